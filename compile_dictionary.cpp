@@ -0,0 +1,12 @@
+#include "dictionary.h"
+#include <iostream>
+
+//Compile a word list into the binary dictionary format read by wordsquares,
+//rank_solutions and wordfeud_planner
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " WORDLIST.txt OUTPUT.wsd" << std::endl;
+    return 1;
+  }
+  return Dictionary::compile(argv[1], argv[2]) ? 0 : 1;
+}
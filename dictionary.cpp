@@ -0,0 +1,425 @@
+#include "dictionary.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char DICT_MAGIC[8] = { 'W', 'S', 'Q', 'D', 'I', 'C', 'T', 0 };
+
+//Byte translation tables for NormalizeWord (0 = not a letter)
+struct NormalizeTables {
+  char ascii[256];   //Single-byte letters, a-z and A-Z to upper case
+  char c3[256];      //Second byte of a two-byte UTF-8 letter starting with 0xC3
+  NormalizeTables() {
+    std::memset(ascii, 0, sizeof(ascii));
+    std::memset(c3, 0, sizeof(c3));
+    for (int c = 'A'; c <= 'Z'; ++c) {
+      ascii[c] = (char)c;
+      ascii[c - 'A' + 'a'] = (char)c;
+    }
+    c3[0x85] = c3[0xA5] = 'Q';   // Å å
+    c3[0x84] = c3[0xA4] = 'W';   // Ä ä
+    c3[0x96] = c3[0xB6] = '[';   // Ö ö
+  }
+};
+static const NormalizeTables g_normalize;
+
+std::string NormalizeWord(const std::string& line) {
+  std::string word;
+  word.reserve(line.size());
+  const unsigned char* p = (const unsigned char*)line.data();
+  const size_t n = line.size();
+  for (size_t i = 0; i < n; ++i) {
+    const char letter = g_normalize.ascii[p[i]];
+    if (letter != 0) {
+      word += letter;
+    } else if (p[i] >= 0x80) {
+      //Non-ASCII: only Å, Ä and Ö (0xC3 and one more byte) are in the WordFeud alphabet
+      const char swedish = (p[i] == 0xC3 && i + 1 < n) ? g_normalize.c3[p[++i]] : 0;
+      if (swedish == 0) return std::string();
+      word += swedish;
+    }
+  }
+  return word;
+}
+
+bool Dictionary::stamp(const std::string& fname, uint64_t& size, int64_t& mtime) {
+  struct stat st;
+  if (stat(fname.c_str(), &st) != 0) return false;
+  size = (uint64_t)st.st_size;
+  mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+//Seeded hash of a fixed-length word; seed 0 picks the bucket, the bucket's seed the slot
+static inline uint64_t HashWord(const char* word, int length, uint64_t seed) {
+  uint64_t h = 0x9E3779B97F4A7C15ull * (seed + 1);
+  for (int i = 0; i < length; ++i) {
+    h = (h ^ (unsigned char)word[i]) * 0x100000001B3ull;
+  }
+  //Final mix (MurmurHash3 fmix64) so every letter reaches the low bits
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+void WordTable::build(const std::vector<std::string>& words, int length) {
+  m_length = length;
+  m_num_words = words.size();
+
+  //About four words per bucket; the largest buckets pick their seeds first
+  const size_t num_buckets = words.size() / 4 + 1;
+  std::vector<std::vector<uint32_t>> buckets(num_buckets);
+  for (uint32_t w = 0; w < words.size(); ++w) {
+    buckets[HashWord(words[w].data(), length, 0) % num_buckets].push_back(w);
+  }
+  std::vector<uint32_t> order(num_buckets);
+  for (uint32_t b = 0; b < num_buckets; ++b) order[b] = b;
+  std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  //Find a seed per bucket that sends all its words to distinct free slots, with
+  //20% spare slots; in the unlikely case a bucket finds none, retry with more slots
+  const uint32_t MAX_SEED = 1u << 16;
+  m_num_slots = words.size() + words.size() / 4 + 1;
+  std::vector<size_t> slots;
+  for (bool placed_all = false; !placed_all; ) {
+    m_seed_store.assign(num_buckets, 0);
+    std::vector<bool> used(m_num_slots, false);
+    placed_all = true;
+    for (uint32_t b : order) {
+      if (buckets[b].empty()) break;
+      uint32_t seed = 1;
+      for (; seed < MAX_SEED; ++seed) {
+        slots.clear();
+        for (uint32_t w : buckets[b]) {
+          const size_t slot = HashWord(words[w].data(), length, seed) % m_num_slots;
+          if (used[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) break;
+          slots.push_back(slot);
+        }
+        if (slots.size() == buckets[b].size()) break;
+      }
+      if (seed == MAX_SEED) {
+        placed_all = false;
+        m_num_slots += m_num_slots / 8 + 1;
+        break;
+      }
+      m_seed_store[b] = seed;
+      for (size_t slot : slots) used[slot] = true;
+    }
+  }
+
+  m_slot_store.assign(m_num_slots * length, 0);
+  for (uint32_t b = 0; b < num_buckets; ++b) {
+    for (uint32_t w : buckets[b]) {
+      const size_t slot = HashWord(words[w].data(), length, m_seed_store[b]) % m_num_slots;
+      std::memcpy(&m_slot_store[slot * length], words[w].data(), length);
+    }
+  }
+  m_num_buckets = num_buckets;
+  m_seeds = m_seed_store.data();
+  m_slots = m_slot_store.data();
+}
+
+void WordTable::attach(int length, size_t num_words, const uint32_t* seeds, size_t num_buckets,
+                       const char* slots, size_t num_slots) {
+  m_seed_store.clear();
+  m_slot_store.clear();
+  m_length = length;
+  m_num_words = num_words;
+  m_seeds = seeds;
+  m_num_buckets = num_buckets;
+  m_slots = slots;
+  m_num_slots = num_slots;
+}
+
+bool WordTable::has(const char* word) const {
+  if (m_num_words == 0) return false;
+  const uint32_t seed = m_seeds[HashWord(word, m_length, 0) % m_num_buckets];
+  const size_t slot = HashWord(word, m_length, seed) % m_num_slots;
+  return std::memcmp(&m_slots[slot * m_length], word, m_length) == 0;
+}
+
+Dictionary::~Dictionary() {
+  unmap();
+}
+
+bool Dictionary::isCompiled(const std::string& fname) {
+  std::ifstream fin(fname, std::ios::binary);
+  char magic[sizeof(DICT_MAGIC)] = {};
+  return fin.read(magic, sizeof(magic)) && std::memcmp(magic, DICT_MAGIC, sizeof(magic)) == 0;
+}
+
+std::string Dictionary::cachePath(const std::string& text_fname) {
+  const size_t slash = text_fname.find_last_of('/');
+  const size_t dot = text_fname.find_last_of('.');
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+    return text_fname.substr(0, dot) + ".wsd";
+  }
+  return text_fname + ".wsd";
+}
+
+bool Dictionary::compile(const std::string& text_fname, const std::string& out_fname) {
+  Dictionary dictionary;
+  if (!dictionary.build(text_fname)) {
+    return false;
+  }
+  if (!dictionary.save(out_fname)) {
+    std::cerr << "Failed to write " << out_fname << std::endl;
+    return false;
+  }
+  std::cout << "Compiled " << dictionary.numWords(0) << " words into " << out_fname
+            << " (" << dictionary.m_size / 1024 << " KB)" << std::endl;
+  return true;
+}
+
+bool Dictionary::open(const std::string& fname) {
+  if (isCompiled(fname)) {
+    if (!map(fname)) {
+      std::cerr << "Unsupported compiled dictionary " << fname << ", recompile it" << std::endl;
+      return false;
+    }
+    return true;
+  }
+  //A word list is served from its cache for as long as the cache was built from this version
+  uint64_t source_size = 0;
+  int64_t source_mtime = 0;
+  if (!stamp(fname, source_size, source_mtime)) {
+    std::cerr << "Cannot open word list " << fname << std::endl;
+    return false;
+  }
+  const std::string cache = cachePath(fname);
+  if (map(cache)) {
+    const DictHeader* header = (const DictHeader*)m_base;
+    if (header->source_size == source_size && header->source_mtime == source_mtime) {
+      return true;
+    }
+  }
+  //Release a stale cache before rebuilding rather than holding both images
+  unmap();
+  if (!build(fname)) {
+    return false;
+  }
+  if (!save(cache)) {
+    std::cerr << "Cannot write dictionary cache " << cache << ", continuing without it" << std::endl;
+  }
+  return true;
+}
+
+bool Dictionary::map(const std::string& fname) {
+  unmap();
+  const int fd = ::open(fname.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DictHeader)) {
+    close(fd);
+    return false;
+  }
+  void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+  m_map = map;
+  m_map_size = st.st_size;
+  return useImage((const char*)m_map, m_map_size, fname);
+}
+
+void Dictionary::unmap() {
+  if (m_map == nullptr) return;
+  if (m_base == (const char*)m_map) {
+    m_base = nullptr;
+    m_size = 0;
+    m_entries.clear();
+    m_tries.clear();
+    m_tables.clear();
+  }
+  munmap(m_map, m_map_size);
+  m_map = nullptr;
+  m_map_size = 0;
+}
+
+bool Dictionary::build(const std::string& text_fname) {
+  std::ifstream fin(text_fname, std::ios::binary);
+  if (!fin) {
+    std::cerr << "Cannot open word list " << text_fname << std::endl;
+    return false;
+  }
+  DictHeader header = {};
+  std::memcpy(header.magic, DICT_MAGIC, sizeof(DICT_MAGIC));
+  header.version = VERSION;
+  header.num_tries = DICT_MAX_LENGTH + 1;
+  stamp(text_fname, header.source_size, header.source_mtime);
+
+  //Read and normalise the file once, bucketing the words by length
+  std::stringstream contents;
+  contents << fin.rdbuf();
+  std::vector<std::vector<std::string>> words(DICT_MAX_LENGTH + 1);
+  std::string line;
+  while (std::getline(contents, line)) {
+    std::string word = NormalizeWord(line);
+    if (word.empty() || word.size() > DICT_MAX_LENGTH) continue;
+    words[word.size()].push_back(std::move(word));
+  }
+  //A word listed twice would never get a slot of its own in the word table
+  for (std::vector<std::string>& bucket : words) {
+    std::sort(bucket.begin(), bucket.end());
+    bucket.erase(std::unique(bucket.begin(), bucket.end()), bucket.end());
+  }
+
+  //Trie 0 holds every word, trie n and word table n the words of length n; each
+  //length is built on its own thread
+  std::vector<Trie> tries(DICT_MAX_LENGTH + 1);
+  std::vector<WordTable> tables(DICT_MAX_LENGTH + 1);
+  std::vector<std::thread> threads;
+  threads.emplace_back([&tries, &words] {
+    for (const std::vector<std::string>& bucket : words) {
+      for (const std::string& word : bucket) tries[0].add(word);
+    }
+    tries[0].finalize();
+  });
+  for (int length = 1; length <= DICT_MAX_LENGTH; ++length) {
+    threads.emplace_back([&tries, &tables, &words, length] {
+      for (const std::string& word : words[length]) tries[length].add(word);
+      tries[length].finalize();
+      tables[length].build(words[length], length);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  //Lay out the image: header, entry table, the 8-byte aligned node arrays, then
+  //the 8-byte aligned word tables
+  std::vector<DictTrieEntry> entries(tries.size());
+  uint64_t offset = sizeof(DictHeader) + entries.size() * sizeof(DictTrieEntry);
+  offset = (offset + 7) & ~(uint64_t)7;
+  for (size_t length = 0; length < tries.size(); ++length) {
+    entries[length].length = (uint32_t)length;
+    entries[length].num_words = (uint32_t)words[length].size();
+    entries[length].offset = offset;
+    entries[length].num_nodes = tries[length].size();
+    offset += tries[length].size() * sizeof(Trie::Node);
+  }
+  for (size_t length = 1; length < tables.size(); ++length) {
+    offset = (offset + 7) & ~(uint64_t)7;
+    entries[length].table_offset = offset;
+    entries[length].num_buckets = (uint32_t)tables[length].numBuckets();
+    entries[length].num_slots = (uint32_t)tables[length].numSlots();
+    offset += tables[length].numBuckets() * sizeof(uint32_t) + tables[length].numSlots() * length;
+  }
+  offset = (offset + 7) & ~(uint64_t)7;
+  for (size_t length = 1; length < tries.size(); ++length) {
+    entries[0].num_words += entries[length].num_words;
+  }
+  m_image.assign(offset / sizeof(uint64_t), 0);
+  char* image = (char*)m_image.data();
+  std::memcpy(image, &header, sizeof(header));
+  std::memcpy(image + sizeof(header), entries.data(), entries.size() * sizeof(DictTrieEntry));
+  for (size_t length = 0; length < tries.size(); ++length) {
+    std::memcpy(image + entries[length].offset, tries[length].data(), tries[length].size() * sizeof(Trie::Node));
+  }
+  for (size_t length = 1; length < tables.size(); ++length) {
+    const size_t seeds_size = tables[length].numBuckets() * sizeof(uint32_t);
+    std::memcpy(image + entries[length].table_offset, tables[length].seeds(), seeds_size);
+    std::memcpy(image + entries[length].table_offset + seeds_size, tables[length].slots(),
+                tables[length].numSlots() * length);
+  }
+  return useImage(image, offset, text_fname);
+}
+
+bool Dictionary::save(const std::string& fname) const {
+  //Write to a temporary file so running processes never map a partial dictionary
+  const std::string tmp_fname = fname + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream fout(tmp_fname, std::ios::binary);
+    fout.write(m_base, m_size);
+    if (!fout) {
+      fout.close();
+      std::remove(tmp_fname.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_fname.c_str(), fname.c_str()) != 0) {
+    std::remove(tmp_fname.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool Dictionary::useImage(const char* base, size_t size, const std::string& name) {
+  //Validate the header and that every node array and word table lies inside the image
+  const DictHeader* header = (const DictHeader*)base;
+  if (size < sizeof(DictHeader) || std::memcmp(header->magic, DICT_MAGIC, sizeof(DICT_MAGIC)) != 0 ||
+      header->version != VERSION || sizeof(DictHeader) + (uint64_t)header->num_tries * sizeof(DictTrieEntry) > size) {
+    return false;
+  }
+  const DictTrieEntry* entries = (const DictTrieEntry*)(base + sizeof(DictHeader));
+  for (uint32_t t = 0; t < header->num_tries; ++t) {
+    const DictTrieEntry& e = entries[t];
+    const uint64_t table_size = (uint64_t)e.num_buckets * sizeof(uint32_t) + (uint64_t)e.num_slots * e.length;
+    if (e.num_nodes == 0 || e.offset % 8 != 0 || e.offset + e.num_nodes * sizeof(Trie::Node) > size ||
+        e.length > DICT_MAX_LENGTH || e.table_offset % 8 != 0 || e.table_offset + table_size > size ||
+        (e.length > 0 && e.num_words > 0 && (e.num_buckets == 0 || e.num_slots == 0))) {
+      std::cerr << "Corrupt compiled dictionary " << name << std::endl;
+      return false;
+    }
+  }
+  m_base = base;
+  m_size = size;
+  m_entries.clear();
+  m_tries.clear();
+  m_tries.resize(header->num_tries);
+  m_tables.clear();
+  m_tables.resize(DICT_MAX_LENGTH + 1);
+  for (uint32_t t = 0; t < header->num_tries; ++t) {
+    const DictTrieEntry& e = entries[t];
+    m_entries.push_back(&e);
+    m_tries[t].attach((const Trie::Node*)(base + e.offset), e.num_nodes);
+    if (e.length > 0) {
+      const uint32_t* seeds = (const uint32_t*)(base + e.table_offset);
+      m_tables[e.length].attach(e.length, e.num_words, seeds, e.num_buckets,
+                                (const char*)(seeds + e.num_buckets), e.num_slots);
+    }
+  }
+  return true;
+}
+
+const DictTrieEntry* Dictionary::entry(int length) const {
+  for (const DictTrieEntry* e : m_entries) {
+    if ((int)e->length == length) return e;
+  }
+  return nullptr;
+}
+
+const Trie* Dictionary::trie(int length) const {
+  for (size_t t = 0; t < m_entries.size(); ++t) {
+    if ((int)m_entries[t]->length == length) return &m_tries[t];
+  }
+  return nullptr;
+}
+
+bool Dictionary::attach(int length, Trie& trie) const {
+  const DictTrieEntry* e = entry(length);
+  if (e == nullptr) return false;
+  trie.attach((const Trie::Node*)(m_base + e->offset), e->num_nodes);
+  return true;
+}
+
+WordView Dictionary::view(int min_length, int max_length) const {
+  return WordView(trie(0), m_tables.data(), min_length, std::min(max_length, DICT_MAX_LENGTH));
+}
+
+uint32_t Dictionary::numWords(int length) const {
+  const DictTrieEntry* e = entry(length);
+  return (e == nullptr) ? 0 : e->num_words;
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include "trie.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Longest word stored in a dictionary (a WordFeud board row)
+#define DICT_MAX_LENGTH 15
+
+//Convert a dictionary line to the internal alphabet: upper case A-Z with
+//Å -> 'Q', Ä -> 'W', Ö -> '['. Other ASCII bytes are dropped; a word with any
+//other non-ASCII byte (another letter, or broken UTF-8) gives an empty string.
+std::string NormalizeWord(const std::string& line);
+
+//Compiled dictionary image: the packed tries and word tables of a word list. It is
+//written to a file once and memory-mapped read-only afterwards, so loading needs no
+//parsing and concurrent processes share the same pages.
+//
+//Layout (native byte order, the file is a local build artefact):
+//  DictHeader
+//  DictTrieEntry[num_tries]
+//  Trie::Node arrays, each 8-byte aligned at its entry's offset
+//  WordTable seeds (uint32_t[num_buckets]) followed by its slots (num_slots * length
+//  letters), each table 8-byte aligned at its entry's table_offset
+//Entry length 0 holds all words; entries 1..DICT_MAX_LENGTH hold the words of one length.
+struct DictHeader {
+  char magic[8];          //"WSQDICT\0"
+  uint32_t version;
+  uint32_t num_tries;
+  uint64_t source_size;   //Size and modification time of the word list it was built from
+  int64_t source_mtime;
+};
+
+struct DictTrieEntry {
+  uint32_t length;      //Word length, 0 = all lengths
+  uint32_t num_words;
+  uint64_t offset;      //Byte offset of the node array from the start of the image
+  uint64_t num_nodes;
+  uint64_t table_offset;  //Byte offset of the word table, 0 for entry 0
+  uint32_t num_buckets;
+  uint32_t num_slots;
+};
+
+//Perfect-hash set of the words of one length (hash and displace: every word has
+//its own slot, found with two hashes and checked with one compare). Used to check
+//whole words of grids that did not come out of a trie walk. Tables are built with
+//the dictionary image and stored in it, so opening a dictionary builds nothing.
+class WordTable {
+public:
+  WordTable() = default;
+  WordTable(const WordTable&) = delete;
+  WordTable& operator=(const WordTable&) = delete;
+  WordTable(WordTable&&) = default;
+  WordTable& operator=(WordTable&&) = default;
+
+  //Place `words`, distinct and all `length` letters long
+  void build(const std::vector<std::string>& words, int length);
+  //Use seeds and slots stored elsewhere; they must outlive the table
+  void attach(int length, size_t num_words, const uint32_t* seeds, size_t num_buckets,
+              const char* slots, size_t num_slots);
+  //`word` points at `length` letters
+  bool has(const char* word) const;
+  inline int length() const { return m_length; }
+  inline size_t size() const { return m_num_words; }
+  //The seed and slot arrays, e.g. for serialization
+  inline const uint32_t* seeds() const { return m_seeds; }
+  inline size_t numBuckets() const { return m_num_buckets; }
+  inline const char* slots() const { return m_slots; }
+  inline size_t numSlots() const { return m_num_slots; }
+
+private:
+  int m_length = 0;
+  size_t m_num_words = 0;
+  size_t m_num_buckets = 0;
+  size_t m_num_slots = 0;
+  //Arrays in use: the stores after build(), or external storage after attach()
+  const uint32_t* m_seeds = nullptr;   //Displacement seed per bucket
+  const char* m_slots = nullptr;       //m_length letters per slot, all zero when empty
+  std::vector<uint32_t> m_seed_store;
+  std::vector<char> m_slot_store;
+};
+
+//The words of a dictionary restricted to a range of lengths
+class WordView {
+public:
+  WordView() = default;
+  WordView(const Trie* trie, const WordTable* tables, int min_length, int max_length)
+    : m_trie(trie), m_tables(tables), m_min_length(min_length), m_max_length(max_length) {}
+
+  inline bool has(const std::string& word) const {
+    return has(word.data(), (int)word.size());
+  }
+  //`word` points at `length` letters, e.g. a run of a board row; two hashes, no trie walk
+  inline bool has(const char* word, int length) const {
+    if (length < m_min_length || length > m_max_length) return false;
+    return m_tables[length].has(word);
+  }
+  inline const Trie& trie() const { return *m_trie; }
+
+private:
+  const Trie* m_trie = nullptr;
+  const WordTable* m_tables = nullptr;   //Indexed by word length
+  int m_min_length = 0;
+  int m_max_length = 0;
+};
+
+//Word list shared by the solver, ranker and planner. A plain word list is parsed
+//once and its image cached next to it (cachePath), so later runs of any of the
+//programs only map the cache.
+class Dictionary {
+public:
+  static const uint32_t VERSION = 3;
+
+  Dictionary() = default;
+  Dictionary(const Dictionary&) = delete;
+  Dictionary& operator=(const Dictionary&) = delete;
+  ~Dictionary();
+
+  //True if the file starts with the compiled dictionary magic
+  static bool isCompiled(const std::string& fname);
+  //Cache file used for a word list: its name with the extension replaced by .wsd
+  static std::string cachePath(const std::string& text_fname);
+  //Size and modification time (ns) identifying one version of a file, false if it is missing
+  static bool stamp(const std::string& fname, uint64_t& size, int64_t& mtime);
+  //Read a word list and write it as a compiled dictionary, false on I/O errors
+  static bool compile(const std::string& text_fname, const std::string& out_fname);
+
+  //Open a compiled dictionary, or a word list through its cache (rebuilt when stale)
+  bool open(const std::string& fname);
+  //Map a compiled dictionary read-only, false if it is missing or malformed
+  bool map(const std::string& fname);
+
+  //Trie of the words of `length` (0 = all words), or nullptr
+  const Trie* trie(int length) const;
+  //Point `trie` at the trie for words of `length` (0 = all words)
+  bool attach(int length, Trie& trie) const;
+  //All words with min_length <= length <= max_length
+  WordView view(int min_length, int max_length) const;
+  //Number of words of `length` (0 = all words)
+  uint32_t numWords(int length) const;
+
+private:
+  bool build(const std::string& text_fname);
+  bool save(const std::string& fname) const;
+  //Drop the mapped file, and the views into it if it is the image in use
+  void unmap();
+  bool useImage(const char* base, size_t size, const std::string& name);
+  const DictTrieEntry* entry(int length) const;
+
+  void* m_map = nullptr;               //Mapped file, if any
+  size_t m_map_size = 0;
+  std::vector<uint64_t> m_image;       //Image built in memory from a word list
+  const char* m_base = nullptr;        //Image in use (mapped or built)
+  size_t m_size = 0;
+  std::vector<const DictTrieEntry*> m_entries;
+  std::vector<Trie> m_tries;           //One view per entry
+  std::vector<WordTable> m_tables;     //Views of the word tables, indexed by length
+};
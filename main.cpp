@@ -1,4 +1,5 @@
 #include "trie.h"
+#include "dictionary.h"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -23,21 +24,32 @@
 #ifdef ENABLE_THREADING
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <deque>
+#include <memory>
 #endif
 
-#ifdef ENABLE_PGO_FLUSH
 #include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef ENABLE_PGO_FLUSH
 // Weak declaration so builds without PGO still link
 extern "C" void __gcov_flush() __attribute__((weak));
-// Graceful shutdown flag set by signal handler
-static volatile sig_atomic_t g_exit_requested = 0;
+#endif
+// Graceful shutdown flag set by signal handler (Ctrl-C, SIGTERM on reboot)
+// Workers poll it from other threads, so it must be a lock-free atomic rather than
+// volatile; relaxed is enough since the parking handshake orders the frontier data
+static std::atomic<bool> g_exit_requested{false};
+static_assert(std::atomic<bool>::is_always_lock_free);
 static void HandleSignal(int /*signum*/) {
-  // Only set a flag; main thread will flush once after threads stop
-  g_exit_requested = 1; // Async-signal-safe flag set only
+  // Only set a flag; the search unwinds and main writes the checkpoint / flushes once
+  g_exit_requested.store(true, std::memory_order_relaxed); // Async-signal-safe flag set only
 }
-#endif
 
+//Defaults for the runtime configuration (see Usage() for the command line / config file)
 //Path to the dictionary file
 //Recommended source: https://raw.githubusercontent.com/andrewchen3019/wordle/refs/heads/main/Collins%20Scrabble%20Words%20(2019).txt
 #define DICTIONARY "WordFeud_ordlista.txt"
@@ -48,6 +60,9 @@ static void HandleSignal(int /*signum*/) {
 #define SIZE_W 15
 //Height of the word grid
 #define SIZE_H 15
+//Largest supported grid width/height (sizes the per-thread search arrays)
+#define MAX_SIZE 15
+#define MAX_CELLS (MAX_SIZE * MAX_SIZE)
 //Filter horizontal words to be in the top-N (or 0 for all words)
 #define MIN_FREQ_W 0
 //Filter vertical words to be in the top-N (or 0 for all words)
@@ -56,21 +71,83 @@ static void HandleSignal(int /*signum*/) {
 #define UNIQUE false
 //Diagonals must also be words (only for square grids)
 #define DIAGONALS false
-
-//WordFeud letter distribution (includes blanks as wildcards)
-static const std::unordered_map<char, int> g_wordfeud_letters = {
-  {'A', 9}, {'B', 2}, {'C', 1}, {'D', 5}, {'E', 8}, {'F', 2},
-  {'G', 3}, {'H', 2}, {'I', 5}, {'J', 1}, {'K', 3}, {'L', 5},
-  {'M', 3}, {'N', 6}, {'O', 6}, {'P', 2}, {'R', 8}, {'S', 8},
-  {'T', 9}, {'U', 3}, {'V', 2}, {'X', 1}, {'Y', 1}, {'Z', 1},
-  {'Q', 2}, {'W', 2}, {'[', 2} // Q=Å, W=Ä, [=Ö
+//Number of leading cells fixed by the initial parallel tasks
+#define SPLIT_DEPTH 2
+//Busy threads hand untried letters at depths below this to idle threads
+#define MAX_SPLIT_DEPTH 32
+//Seconds between checkpoints of the search frontier (when run with --checkpoint FILE)
+#define CHECKPOINT_INTERVAL 600
+//Seconds between progress reports of the parallel search
+#define REPORT_INTERVAL 10
+//Leading letters (in search order) of each thread's current subtree shown in progress reports
+#define PROGRESS_PREFIX 3
+//Fill the open cell with the fewest candidate letters first instead of row-major order
+#define MCV_ORDER false
+//Search engine: fill one cell at a time (false) or place whole words in the row segments (true)
+#define WORD_ENGINE false
+//Solutions as human-readable grids (false) or one JSON object per line (true)
+#define JSONL_OUTPUT false
+//How often the writer thread moves buffered solutions to the output
+#define SOLUTION_FLUSH_MS 200
+//Square shapes equal to their own transpose: only search grids that are not greater
+//than their transpose, so each transposed pair of solutions is found once
+#define BREAK_SYMMETRY true
+
+//Runtime configuration, initialised from the defaults above
+struct Config {
+  int width = SIZE_W;
+  int height = SIZE_H;
+  std::string dictionary = DICTIONARY;
+  std::string freq_filter = FREQ_FILTER;
+  int min_freq_w = MIN_FREQ_W;
+  int min_freq_h = MIN_FREQ_H;
+  bool unique = UNIQUE;
+  bool mcv_order = MCV_ORDER;         //--order mcv
+  bool word_engine = WORD_ENGINE;     //--engine word
+  bool symmetry = BREAK_SYMMETRY;     //--symmetry
+  bool diagonals = DIAGONALS;         //--diagonals
+  bool jsonl = JSONL_OUTPUT;          //--format jsonl
+  std::string solutions_file;         //Empty = solutions go to stdout with the other output
+  std::string checkpoint_file;        //Empty = checkpointing disabled
+  std::vector<std::string> shape_rows; //Replaces the default g_shape_mask when non-empty
+};
+Config g_config;
+
+//WordFeud letter distribution indexed by letter ('A' + ix), blanks are counted separately
+static const int g_wordfeud_letters[NUM_LETTERS] = {
+  9, 2, 1, 5, 8, 2,   // A B C D E F
+  3, 2, 5, 1, 3, 5,   // G H I J K L
+  3, 6, 6, 2, 2, 8,   // M N O P Q R
+  8, 9, 3, 2, 2, 1,   // S T U V W X
+  1, 1, 2             // Y Z [   (Q=Å, W=Ä, [=Ö)
 };
 static const int g_wordfeud_blanks = 2;
 
+//Running WordFeud tile usage, updated in O(1) as letters are placed and removed
+struct TileBudget {
+  int counts[NUM_LETTERS] = {};
+  int blanks_needed = 0;     //Blanks needed to cover letters used beyond their tile count
+  uint32_t exhausted = 0;    //Letters whose tiles are all in use
+
+  inline void add(int ix) {
+    if (++counts[ix] > g_wordfeud_letters[ix]) blanks_needed++;
+    if (counts[ix] >= g_wordfeud_letters[ix]) exhausted |= 1u << ix;
+  }
+  inline void remove(int ix) {
+    if (counts[ix]-- > g_wordfeud_letters[ix]) blanks_needed--;
+    if (counts[ix] < g_wordfeud_letters[ix]) exhausted &= ~(1u << ix);
+  }
+  //Letters that can still be placed without exceeding the tile limits
+  inline uint32_t available() const {
+    return (blanks_needed < g_wordfeud_blanks) ? Trie::LETTER_MASK : (Trie::LETTER_MASK & ~exhausted);
+  }
+  inline bool fits() const { return blanks_needed <= g_wordfeud_blanks; }
+};
+
 //Shape mask: true = valid position, false = empty/blocked position
-//EDIT THIS MANUALLY to define your custom shape:
+//Default shape, replaced by --shape/--size or the config file:
 //true = letter goes here, false = empty space
-static bool g_shape_mask[SIZE_H][SIZE_W] = {
+static bool g_shape_mask[MAX_SIZE][MAX_SIZE] = {
   {false,true,true,true,true,false,true,false,true,true,true,false},
   {true,false,true,true,true,true,true,true,true,true,false,true},
   {true,true,false,true,true,false,true,false,true,false,true,true},
@@ -85,6 +162,72 @@ static bool g_shape_mask[SIZE_H][SIZE_W] = {
 
 };
 
+//Axes along which word segments run: rows, columns and (--diagonals) the main
+//diagonal and the anti-diagonal of a square grid, both read top to bottom
+enum { AXIS_H = 0, AXIS_V = 1, NUM_GRID_AXES = 2, AXIS_D = 2, AXIS_A = 3, NUM_AXES = 4 };
+
+//A maximal run of valid cells along one axis; each one must form a word
+struct Segment {
+  int axis;
+  int start_pos;
+  int length;
+  int step;          //Position difference between consecutive cells
+  const Trie* trie;  //Length-specific trie for the segment
+};
+
+//Per-cell topology, precomputed so the search never scans the shape mask
+struct ShapeCell {
+  int pos;                      //Grid position (h * width + w)
+  int num_axes;                 //Axes with a segment through the cell: AXIS_H, AXIS_V, then diagonals
+  int axes[NUM_AXES];
+  int seg[NUM_AXES];            //Segment id on each axis, or -1
+  int offset[NUM_AXES];         //Offset of the cell within that segment
+  int length[NUM_AXES];         //Length of that segment
+  int prev[NUM_AXES];           //Position of the previous cell in the segment, or -1 at its start
+  int next[NUM_AXES];           //Position of the next cell in the segment, or -1 at its end
+  bool is_end[NUM_AXES];        //The cell completes the segment
+  int mirror;                   //Position of the transposed cell if it is filled before this one
+                                //and symmetry breaking is on, else -1
+  bool unique_end[NUM_AXES];    //The cell completes a word that must differ from all others (--unique)
+  const Trie* trie[NUM_AXES];   //Length-specific trie for the segment
+};
+
+//Call f(axis) for each axis of the cell. Rows and columns run through every cell and
+//are named as constants, so the per-axis cursors of the hot path stay in registers.
+template <typename F>
+inline void ForEachAxis(const ShapeCell& cell, F f) {
+  f(AXIS_H);
+  f(AXIS_V);
+  for (int a = NUM_GRID_AXES; a < cell.num_axes; ++a) f(cell.axes[a]);
+}
+
+//True if f(axis) holds for each axis of the cell, stopping at the first that fails
+template <typename F>
+inline bool AllAxes(const ShapeCell& cell, F f) {
+  if (!f(AXIS_H) || !f(AXIS_V)) return false;
+  for (int a = NUM_GRID_AXES; a < cell.num_axes; ++a) {
+    if (!f(cell.axes[a])) return false;
+  }
+  return true;
+}
+
+//Compiled shape descriptor built once from g_shape_mask
+struct Shape {
+  std::vector<ShapeCell> cells;            //Fillable cells in row-major order
+  std::vector<Segment> segments;
+  int cell_index[MAX_CELLS];               //Position -> index in cells, or -1
+  //Row segments whose crossing prefixes are all known once cell i is filled (--engine word)
+  std::vector<std::vector<int>> ready_segments;
+  int next_valid[MAX_CELLS + 1];           //First valid position >= p, or -1
+  bool transposed = false;                 //Search restricted to grids <= their transpose
+};
+
+//Build g_shape from g_shape_mask (segment tries are attached after loading)
+void CompileShape();
+
+//Point every segment and cell at the length-specific trie for its segment
+void AttachShapeTries();
+
 //Get total number of valid positions in the shape
 int GetValidPositions();
 
@@ -118,7 +261,6 @@ int GetHorizontalWordLength(int row);
 //Get the expected vertical word length for a given column
 int GetVerticalWordLength(int col);
 
-static const int VTRIE_SIZE = (DIAGONALS ? SIZE_W + 2 : SIZE_W);
 static const std::unordered_set<std::string> banned = {
   //Feel free to add words you don't want to see here
 };
@@ -127,111 +269,231 @@ static const std::unordered_set<std::string> banned = {
 #ifdef ENABLE_FREQ_FILTER
 std::unordered_map<std::string, uint32_t> g_freqs;
 #endif
-Trie g_trie_w;
-Trie g_trie_h;
+Dictionary g_dictionary;   //Shared compiled or cached dictionary, when no word filter applies
 std::unordered_map<int, Trie> g_tries_by_length;
+std::unordered_map<int, Trie> g_tries_h_by_length;
+Shape g_shape;
+
+//Per-thread search state: the grid plus, for every filled cell, the trie cursor
+//reached along its segment on each axis. Backtracking only needs to clear the
+//cell; stale cursors are overwritten by the next placement.
+struct SearchState;
+void InitOpenCells(SearchState& state);
+
+struct SearchState {
+  char words[MAX_CELLS] = { 0 };
+  Trie::NodeIx nodes[NUM_AXES][MAX_CELLS] = {};
+  TileBudget tiles;
+  uint32_t remaining[MAX_CELLS] = {};  //Untried candidate letters per depth
+  int untied_pos = -1;                 //Symmetry breaking: first cell that differs from its mirror, or -1
+  uint64_t used_words[MAX_CELLS] = {}; //--unique: ids of the completed words, in completion order
+  int num_used = 0;
+  int base_depth = 0;                         //Depth at which the current task starts
+  int worker = 0;                             //Index of the thread owning this state
+  bool frontier_saved = false;                //Open levels were recorded when stopping
+  //Cell order (see BeginDepth): the cell filled at each depth, and for --order mcv the
+  //open cells with their candidate masks plus what each depth changed in them
+  int order[MAX_CELLS] = {};
+  int open_cells[MAX_CELLS] = {};
+  uint32_t open_masks[MAX_CELLS] = {};
+  int num_open = 0;
+  int chosen_slot[MAX_CELLS] = {};     //Slot of open_cells the depth's cell was taken from
+  uint32_t chosen_mask[MAX_CELLS] = {};
+  int opened[MAX_CELLS] = {};          //Open cells added by the letter placed at each depth
+
+  SearchState() { InitOpenCells(*this); }
+};
 
 #ifdef ENABLE_THREADING
-std::atomic<uint64_t> g_combinations_tried(0);
-std::atomic<int> g_deepest_pos(-1);
-std::atomic<int> g_deepest_unique_pos(-1);
+//A unit of parallel work: the first `depth` cells (in search order) hold `letters`,
+//and cell `depth` may only take letters from `mask`
+struct SearchTask {
+  int depth;
+  uint32_t mask;
+  char letters[MAX_CELLS];
+};
+
+//Per-thread task deque; the owner pops from the back, thieves steal from the front
+struct alignas(64) WorkQueue {
+  std::mutex mutex;
+  std::deque<SearchTask> tasks;
+};
+
+std::unique_ptr<WorkQueue[]> g_queues;
+unsigned int g_num_workers = 0;
+std::atomic<int64_t> g_pending_tasks(0);  //Queued plus running tasks; 0 ends the search
+std::atomic<int> g_queued_tasks(0);
+std::atomic<int> g_idle_workers(0);
+std::atomic<uint64_t> g_donated_tasks(0);
+
+//Checkpointing: workers park at safe points while main writes every unexplored
+//subtree (queued tasks plus the untried letters of each open level) to a file
+std::atomic<bool> g_checkpoint_requested(false);
+std::mutex g_checkpoint_mutex;
+std::condition_variable g_checkpoint_cv;
+int g_parked_workers = 0;                         //Guarded by g_checkpoint_mutex
+int g_live_workers = 0;                           //Guarded by g_checkpoint_mutex
+uint64_t g_checkpoint_generation = 0;             //Guarded by g_checkpoint_mutex
+std::vector<std::vector<SearchTask>> g_frontiers; //Per-worker open subtrees
+uint64_t g_resumed_combinations = 0;              //Combinations tried before the resumed checkpoint
+#endif
+
+#ifdef ENABLE_THREADING
+//Per-thread statistics on their own cache line; only the owning worker writes its slot
+//and the main thread reads them for progress reports, so the hot path has no shared writes
+//and no locks. The deepest grid and the current prefix form a snapshot guarded by a
+//sequence lock: the owner makes seq odd while writing, and a reader retries when seq
+//was odd or changed while it copied.
+struct alignas(64) WorkerStats {
+  std::atomic<uint64_t> combinations{ 0 };
+  int deepest_pos = -1;   //Deepest position this worker has reached (private)
+  std::atomic<uint32_t> seq{ 0 };
+  std::atomic<int> snapshot_deepest{ -1 };
+  std::atomic<int> prefix_length{ 0 };
+  std::atomic<char> prefix[PROGRESS_PREFIX];
+  std::atomic<char> deepest_grid[MAX_CELLS];
+};
+std::unique_ptr<WorkerStats[]> g_worker_stats;
 std::mutex g_print_mutex;
+
+//A copy of one worker's snapshot
+struct ProgressSnapshot {
+  int deepest;
+  int prefix_length;
+  char prefix[PROGRESS_PREFIX];
+  char deepest_grid[MAX_CELLS];
+};
+
+//Owner side of the sequence lock
+inline void BeginSnapshot(WorkerStats& stats) {
+  stats.seq.store(stats.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+inline void EndSnapshot(WorkerStats& stats) {
+  stats.seq.store(stats.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//Copy a worker's snapshot, retrying while the owner is writing it
+void ReadSnapshot(const WorkerStats& stats, ProgressSnapshot& out) {
+  const int num_positions = g_config.width * g_config.height;
+  while (true) {
+    const uint32_t before = stats.seq.load(std::memory_order_acquire);
+    if ((before & 1) == 0) {
+      out.deepest = stats.snapshot_deepest.load(std::memory_order_relaxed);
+      out.prefix_length = stats.prefix_length.load(std::memory_order_relaxed);
+      for (int k = 0; k < PROGRESS_PREFIX; ++k) {
+        out.prefix[k] = stats.prefix[k].load(std::memory_order_relaxed);
+      }
+      for (int pos = 0; pos < num_positions; ++pos) {
+        out.deepest_grid[pos] = stats.deepest_grid[pos].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (stats.seq.load(std::memory_order_relaxed) == before) return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+//Sum of the per-thread combination counters
+uint64_t TotalCombinations() {
+  uint64_t total = 0;
+  for (unsigned int w = 0; w < g_num_workers; ++w) {
+    total += g_worker_stats[w].combinations.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+//Solution output: each worker appends formatted solutions to its own buffer and the
+//writer thread moves them to the output, so a solution costs a string append rather
+//than a flushed write under g_print_mutex
+struct alignas(64) SolutionBuffer {
+  std::mutex mutex;   //Held by the owner while appending and by the writer while taking the text
+  std::string text;
+};
+std::unique_ptr<SolutionBuffer[]> g_solution_buffers;
+std::mutex g_writer_mutex;
+std::condition_variable g_writer_cv;
+bool g_writer_stop = false;   //Guarded by g_writer_mutex
 #else
 uint64_t g_combinations_tried = 0;
 int g_deepest_pos = -1;
-int g_deepest_unique_pos = -1;
 #endif
 
 //Timing variables for combinations per second calculation
 auto g_start_time = std::chrono::high_resolution_clock::now();
 auto g_last_report_time = std::chrono::high_resolution_clock::now();
 
+//Where solutions are written: stdout, or the --solutions file
+std::ofstream g_solutions_file;
+std::ostream* g_solutions_out = &std::cout;
+
+#ifdef ENABLE_FREQ_FILTER
+//True if the word is within the top-N of the frequency list (or no filter applies)
+bool PassesFreqFilter(const std::string& word, int min_freq) {
+  if (g_freqs.empty() || min_freq <= 0) return true;
+  const auto& freq = g_freqs.find(word);
+  return freq != g_freqs.end() && freq->second <= (uint32_t)min_freq;
+}
+#endif
+
 //Dictionary should be list of words separated by newlines
-void LoadDictionary(const char* fname, int length, Trie& trie, int min_freq) {
+//Only used when word filters apply; otherwise the shared Dictionary serves the tries.
+//The file is read and normalised once; words of the needed lengths are bucketed by
+//length and the length-specific tries (horizontal, plus vertical for non-square
+//grids) are then built in parallel, one thread per trie.
+void LoadDictionary(const char* fname, const std::set<int>& lengths) {
   std::cout << "Loading Dictionary " << fname << "..." << std::endl;
-  int num_words = 0;
+  const auto start_time = std::chrono::steady_clock::now();
+  const bool square = (g_config.width == g_config.height);
+  std::vector<std::vector<std::string>> words_w(MAX_SIZE + 1);
+  std::vector<std::vector<std::string>> words_h(MAX_SIZE + 1);
   std::ifstream fin(fname);
   std::string line;
   while (std::getline(fin, line)) {
-    // Remove carriage return if present
-    if (!line.empty() && line.back() == '\r') {
-      line.pop_back();
-    }
-    // Handle UTF-8 Swedish characters FIRST, then check length
-    std::string processed_line;
-    for (size_t i = 0; i < line.size(); ++i) {
-      unsigned char c = line[i];
-      if (c >= 'a' && c <= 'z') {
-        processed_line += (c - 'a' + 'A');
-      } else if (c == 0xC3 && i + 1 < line.size()) {
-        unsigned char next = line[i + 1];
-        if (next == 0x85) { // Å
-          processed_line += 'Q';
-          ++i; // Skip next byte
-        } else if (next == 0x84) { // Ä
-          processed_line += 'W';
-          ++i; // Skip next byte
-        } else if (next == 0x96) { // Ö
-          processed_line += '[';
-          ++i; // Skip next byte
-        } else {
-          processed_line += c;
-        }
-      } else if (c >= 'A' && c <= 'Z') {
-        processed_line += c;
-      }
-    }
-    line = processed_line;
-    // Now check the length after processing
-    if (line.size() != length) { continue; }
+    const std::string word = NormalizeWord(line);
+    if (lengths.count((int)word.size()) == 0) { continue; }
+    if (banned.count(word) != 0) { continue; }
 #ifdef ENABLE_FREQ_FILTER
-    if (g_freqs.size() > 0 && min_freq > 0) {
-      const auto& freq = g_freqs.find(line);
-      if (freq == g_freqs.end() || freq->second > min_freq) { continue; }
-    }
+    if (PassesFreqFilter(word, g_config.min_freq_w)) words_w[word.size()].push_back(word);
+    if (!square && PassesFreqFilter(word, g_config.min_freq_h)) words_h[word.size()].push_back(word);
+#else
+    words_w[word.size()].push_back(word);
+    if (!square) words_h[word.size()].push_back(word);
 #endif
-    if (banned.count(line) != 0) { continue; }
-    trie.add(line);
-    num_words += 1;
   }
-  std::cout << "Loaded " << num_words << " words." << std::endl;
-}
 
-//Check if current partial grid has all unique words
-bool HasUniqueWords(char* words, int pos) {
-  if (!UNIQUE || SIZE_H != SIZE_W) return true;
-
-  std::unordered_set<std::string> used_words;
-
-  //Check complete horizontal words
-  for (int h = 0; h <= pos / SIZE_W; ++h) {
-    int row_start = h * SIZE_W;
-    int row_end = std::min(row_start + SIZE_W - 1, pos);
-    if (row_end - row_start + 1 == SIZE_W) {
-      std::string word(words + row_start, SIZE_W);
-      if (used_words.count(word)) return false;
-      used_words.insert(word);
+  //Create every trie up front; the threads only fill their own
+  std::vector<std::pair<Trie*, const std::vector<std::string>*>> jobs;
+  size_t num_words = 0;
+  for (int length : lengths) {
+    jobs.emplace_back(&g_tries_by_length[length], &words_w[length]);
+    num_words += words_w[length].size();
+    if (!square) {
+      jobs.emplace_back(&g_tries_h_by_length[length], &words_h[length]);
     }
   }
-
-  //Check complete vertical words
-  for (int w = 0; w < SIZE_W; ++w) {
-    int col_positions = 0;
-    for (int h = 0; h < SIZE_H; ++h) {
-      if (h * SIZE_W + w <= pos) col_positions++;
-      else break;
-    }
-    if (col_positions == SIZE_H) {
-      std::string word;
-      for (int h = 0; h < SIZE_H; ++h) {
-        word += words[h * SIZE_W + w];
-      }
-      if (used_words.count(word)) return false;
-      used_words.insert(word);
+  auto build = [](Trie* trie, const std::vector<std::string>* words) {
+    for (const std::string& word : *words) {
+      trie->add(word);
     }
+    trie->finalize();
+  };
+#ifdef ENABLE_THREADING
+  std::vector<std::thread> threads;
+  for (const auto& job : jobs) {
+    threads.emplace_back(build, job.first, job.second);
   }
-
-  return true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+#else
+  for (const auto& job : jobs) {
+    build(job.first, job.second);
+  }
+#endif
+  const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+  std::cout << "Loaded " << num_words << " words into " << jobs.size() << " tries in "
+            << std::fixed << std::setprecision(0) << elapsed_ms << " ms." << std::endl;
 }
 
 #ifdef ENABLE_FREQ_FILTER
@@ -259,129 +521,204 @@ void LoadFreq(const char* fname) {
 }
 #endif
 
-//Get total number of valid positions in the shape
-int GetValidPositions() {
-  int count = 0;
-  for (int h = 0; h < SIZE_H; ++h) {
-    for (int w = 0; w < SIZE_W; ++w) {
-      if (g_shape_mask[h][w]) count++;
+//Build g_shape from g_shape_mask (segment tries are attached after loading)
+void CompileShape() {
+  Shape& shape = g_shape;
+  const int width = g_config.width;
+  const int height = g_config.height;
+  shape.cells.clear();
+  shape.segments.clear();
+  for (int pos = 0; pos < height * width; ++pos) {
+    shape.cell_index[pos] = -1;
+    if (g_shape_mask[pos / width][pos % width]) {
+      shape.cell_index[pos] = (int)shape.cells.size();
+      ShapeCell cell = {};
+      cell.pos = pos;
+      for (int axis = 0; axis < NUM_AXES; ++axis) {
+        cell.seg[axis] = -1;
+        cell.prev[axis] = -1;
+        cell.next[axis] = -1;
+      }
+      shape.cells.push_back(cell);
+    }
+  }
+  shape.next_valid[height * width] = -1;
+  for (int pos = height * width - 1; pos >= 0; --pos) {
+    shape.next_valid[pos] = (shape.cell_index[pos] >= 0) ? pos : shape.next_valid[pos + 1];
+  }
+
+  //Walk each segment from its first cell. A diagonal is a word only where it runs
+  //through at least two valid cells; a single cell between holes is left free.
+  const int step_h[NUM_AXES] = { 0, 1, 1, 1 };
+  const int step_w[NUM_AXES] = { 1, 0, 1, -1 };
+  auto is_valid = [&](int h, int w) {
+    return h >= 0 && h < height && w >= 0 && w < width && shape.cell_index[h * width + w] >= 0;
+  };
+  for (size_t i = 0; i < shape.cells.size(); ++i) {
+    const int start_pos = shape.cells[i].pos;
+    const int h = start_pos / width;
+    const int w = start_pos % width;
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+      if (axis == AXIS_D && !(g_config.diagonals && h == w)) continue;
+      if (axis == AXIS_A && !(g_config.diagonals && h + w == width - 1)) continue;
+      if (is_valid(h - step_h[axis], w - step_w[axis])) {
+        continue; //Not a segment start
+      }
+      int length = 1;
+      while (is_valid(h + length * step_h[axis], w + length * step_w[axis])) {
+        length++;
+      }
+      if (axis >= AXIS_D && length < 2) continue;
+      const int step = step_h[axis] * width + step_w[axis];
+      const int seg = (int)shape.segments.size();
+      shape.segments.push_back(Segment{ axis, start_pos, length, step, nullptr });
+      for (int k = 0; k < length; ++k) {
+        ShapeCell& cell = shape.cells[shape.cell_index[start_pos + k * step]];
+        cell.seg[axis] = seg;
+        cell.offset[axis] = k;
+        cell.length[axis] = length;
+        cell.prev[axis] = (k == 0) ? -1 : cell.pos - step;
+        cell.next[axis] = (k == length - 1) ? -1 : cell.pos + step;
+        cell.is_end[axis] = (k == length - 1);
+      }
+    }
+  }
+  for (ShapeCell& cell : shape.cells) {
+    cell.num_axes = 0;
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+      if (cell.seg[axis] >= 0) cell.axes[cell.num_axes++] = axis;
+    }
+  }
+
+  //A row segment is ready after the last of its cells' crossing predecessors
+  shape.ready_segments.assign(shape.cells.size(), std::vector<int>());
+  for (int seg = 0; seg < (int)shape.segments.size(); ++seg) {
+    const Segment& segment = shape.segments[seg];
+    if (segment.axis != AXIS_H) continue;
+    int ready = -1;
+    for (int k = 0; k < segment.length; ++k) {
+      const ShapeCell& cell = shape.cells[shape.cell_index[segment.start_pos + k]];
+      for (int a = 0; a < cell.num_axes; ++a) {
+        const int axis = cell.axes[a];
+        if (axis != AXIS_H && cell.prev[axis] >= 0) ready = std::max(ready, shape.cell_index[cell.prev[axis]]);
+      }
+    }
+    if (ready >= 0) shape.ready_segments[ready].push_back(seg);
+  }
+
+  //Transposing a grid swaps its rows and columns, so when the shape is its own transpose
+  //and both axes use the same words every solution's transpose is a solution too.
+  //Mirroring or rotating reverses words, which only maps solutions to solutions for a
+  //palindrome-closed word list, so the transpose is the only symmetry broken here.
+  //It reverses the anti-diagonal, so not with --diagonals. The dynamic --order mcv
+  //would not compare cells in the same order for a grid and its transpose, so it is
+  //only done in row-major order.
+  shape.transposed = g_config.symmetry && !g_config.mcv_order && !g_config.diagonals && width == height;
+  for (int h = 0; h < height && shape.transposed; ++h) {
+    for (int w = 0; w < h; ++w) {
+      shape.transposed = shape.transposed && g_shape_mask[h][w] == g_shape_mask[w][h];
+    }
+  }
+  for (ShapeCell& cell : shape.cells) {
+    const int h = cell.pos / width;
+    const int w = cell.pos % width;
+    cell.mirror = (shape.transposed && w < h) ? w * width + h : -1;
+  }
+
+  //Uniqueness applies to the words of square grids, where all axes share the length
+  //tries; single-letter segments are not words
+  for (ShapeCell& cell : shape.cells) {
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+      cell.unique_end[axis] = g_config.unique && width == height && cell.is_end[axis] && cell.length[axis] >= 2;
+    }
+  }
+}
+
+//Point every segment and cell at the length-specific trie for its segment
+void AttachShapeTries() {
+  for (Segment& segment : g_shape.segments) {
+    if (segment.axis == AXIS_V && g_config.width != g_config.height) {
+      segment.trie = &g_tries_h_by_length.at(segment.length);
+    } else {
+      segment.trie = &g_tries_by_length.at(segment.length);
+    }
+  }
+  for (ShapeCell& cell : g_shape.cells) {
+    for (int a = 0; a < cell.num_axes; ++a) {
+      cell.trie[cell.axes[a]] = g_shape.segments[cell.seg[cell.axes[a]]].trie;
     }
   }
-  return count;
+}
+
+//Get total number of valid positions in the shape
+int GetValidPositions() {
+  return (int)g_shape.cells.size();
 }
 
 //Check if a grid position is valid according to the shape mask
 bool IsValidPosition(int pos) {
-  if (pos < 0 || pos >= SIZE_H * SIZE_W) return false;
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
-  return g_shape_mask[h][w];
+  if (pos < 0 || pos >= g_config.height * g_config.width) return false;
+  return g_shape.cell_index[pos] >= 0;
 }
 
 //Get the next valid position after pos (or -1 if none)
 int GetNextValidPosition(int pos) {
-  for (int next_pos = pos + 1; next_pos < SIZE_H * SIZE_W; ++next_pos) {
-    if (IsValidPosition(next_pos)) {
-      return next_pos;
-    }
-  }
-  return -1;
+  return g_shape.next_valid[pos + 1];
 }
 
 //Check if position is at the start of a horizontal word segment
 bool IsHorizontalWordStart(int pos) {
   if (!IsValidPosition(pos)) return false;
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
-  return (w == 0) || !IsValidPosition(h * SIZE_W + (w - 1));
+  return g_shape.cells[g_shape.cell_index[pos]].prev[AXIS_H] < 0;
 }
 
 //Check if position is at the end of a horizontal word segment
 bool IsHorizontalWordEnd(int pos) {
   if (!IsValidPosition(pos)) return false;
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
-  return (w == SIZE_W - 1) || !IsValidPosition(h * SIZE_W + (w + 1));
+  return g_shape.cells[g_shape.cell_index[pos]].is_end[AXIS_H];
 }
 
 //Check if position is at the start of a vertical word segment
 bool IsVerticalWordStart(int pos) {
   if (!IsValidPosition(pos)) return false;
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
-  return (h == 0) || !IsValidPosition((h - 1) * SIZE_W + w);
+  return g_shape.cells[g_shape.cell_index[pos]].prev[AXIS_V] < 0;
 }
 
 //Check if position is at the end of a vertical word segment
 bool IsVerticalWordEnd(int pos) {
   if (!IsValidPosition(pos)) return false;
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
-  return (h == SIZE_H - 1) || !IsValidPosition((h + 1) * SIZE_W + w);
+  return g_shape.cells[g_shape.cell_index[pos]].is_end[AXIS_V];
+}
+
+//Build the word of a segment from the grid ("" if any cell is still empty)
+std::string GetSegmentWord(const Segment& segment, const char* words) {
+  std::string word;
+  for (int k = 0; k < segment.length; ++k) {
+    char c = words[segment.start_pos + k * segment.step];
+    if (c == 0) return ""; // Incomplete segment
+    word += c;
+  }
+  return word;
 }
 
 //Get the horizontal word segment containing this position
 std::string GetHorizontalSegment(int pos, char* words) {
   if (!IsValidPosition(pos)) return "";
-
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
-
-  //Find start of segment
-  int start_w = w;
-  while (start_w > 0 && IsValidPosition(h * SIZE_W + (start_w - 1))) {
-    start_w--;
-  }
-
-  //Find end of segment
-  int end_w = w;
-  while (end_w < SIZE_W - 1 && IsValidPosition(h * SIZE_W + (end_w + 1))) {
-    end_w++;
-  }
-
-  //Build segment string
-  std::string segment;
-  for (int i = start_w; i <= end_w; ++i) {
-    char c = words[h * SIZE_W + i];
-    if (c == 0) return ""; // Incomplete segment
-    segment += c;
-  }
-  return segment;
+  const ShapeCell& cell = g_shape.cells[g_shape.cell_index[pos]];
+  return GetSegmentWord(g_shape.segments[cell.seg[AXIS_H]], words);
 }
 
 //Get the vertical word segment containing this position
 std::string GetVerticalSegment(int pos, char* words) {
   if (!IsValidPosition(pos)) return "";
-
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
-
-  //Find start of segment
-  int start_h = h;
-  while (start_h > 0 && IsValidPosition((start_h - 1) * SIZE_W + w)) {
-    start_h--;
-  }
-
-  //Find end of segment
-  int end_h = h;
-  while (end_h < SIZE_H - 1 && IsValidPosition((end_h + 1) * SIZE_W + w)) {
-    end_h++;
-  }
-
-  //Build segment string
-  std::string segment;
-  for (int i = start_h; i <= end_h; ++i) {
-    char c = words[i * SIZE_W + w];
-    if (c == 0) return ""; // Incomplete segment
-    segment += c;
-  }
-  return segment;
+  const ShapeCell& cell = g_shape.cells[g_shape.cell_index[pos]];
+  return GetSegmentWord(g_shape.segments[cell.seg[AXIS_V]], words);
 }
 
 //Get the expected horizontal word length for a given row
 int GetHorizontalWordLength(int row) {
   int count = 0;
-  for (int w = 0; w < SIZE_W; ++w) {
+  for (int w = 0; w < g_config.width; ++w) {
     if (g_shape_mask[row][w]) count++;
   }
   return count;
@@ -390,497 +727,1178 @@ int GetHorizontalWordLength(int row) {
 //Get the expected vertical word length for a given column
 int GetVerticalWordLength(int col) {
   int count = 0;
-  for (int h = 0; h < SIZE_H; ++h) {
+  for (int h = 0; h < g_config.height; ++h) {
     if (g_shape_mask[h][col]) count++;
   }
   return count;
 }
 
 //Check if a completed grid can be played in WordFeud with available letters
-bool CanPlayInWordFeud(char* words) {
-  std::unordered_map<char, int> letter_count;
+bool CanPlayInWordFeud(const char* words) {
+  TileBudget tiles;
+  for (const ShapeCell& cell : g_shape.cells) {
+    if (words[cell.pos] != 0) {
+      tiles.add(words[cell.pos] - 'A');
+    }
+  }
+  return tiles.fits();
+}
 
-  //Count all letters used in the grid
-  for (int pos = 0; pos < SIZE_H * SIZE_W; ++pos) {
-    if (IsValidPosition(pos) && words[pos] != 0) {
-      letter_count[words[pos]]++;
+//Trie cursors extended by the letter placed at a cell. A cell's cursor is one child
+//step from the cursor of the previous cell in the same segment, or from the root of
+//the length-specific trie at a segment start.
+struct CellCursors {
+  const ShapeCell* cell;
+  Trie::NodeIx parent[NUM_AXES];
+};
+
+//Get the parent cursors for cell i (index into g_shape.cells) from the already filled cells
+inline CellCursors GetCellCursors(int i, const SearchState& state) {
+  CellCursors cur;
+  cur.cell = &g_shape.cells[i];
+  ForEachAxis(*cur.cell, [&](int axis) {
+    const int prev = cur.cell->prev[axis];
+    cur.parent[axis] = (prev < 0) ? cur.cell->trie[axis]->root() : state.nodes[axis][prev];
+  });
+  return cur;
+}
+
+//Letters (bit ix for letter 'A' + ix) that extend the prefix on every axis
+inline uint32_t CandidateMask(const CellCursors& cur) {
+  uint32_t mask = Trie::LETTER_MASK;
+  ForEachAxis(*cur.cell, [&](int axis) {
+    mask &= cur.cell->trie[axis]->childMask(cur.parent[axis]);
+  });
+  return mask;
+}
+
+//Place letter ix at the cell and advance its trie cursors (one child lookup per axis).
+//Returns false if the letter has no child on some axis, if a segment completed
+//here is not a word or (--unique) repeats a completed word, or if the grid would
+//become greater than its transpose.
+inline bool PlaceLetter(int ix, const CellCursors& cur, SearchState& state) {
+  const ShapeCell& cell = *cur.cell;
+  //Symmetry breaking: cells below the diagonal are compared with their mirror cells in
+  //fill order. While all of them are equal the grid may still turn out greater than
+  //its transpose; the first cell that is greater than its mirror settles it.
+  bool untie = false;
+  if (cell.mirror >= 0 && state.untied_pos < 0) {
+    const int mirror_ix = state.words[cell.mirror] - 'A';
+    if (ix < mirror_ix) return false;
+    untie = (ix > mirror_ix);
+  }
+  Trie::NodeIx node[NUM_AXES];
+  const bool fits = AllAxes(cell, [&](int axis) {
+    node[axis] = cell.trie[axis]->decend(cur.parent[axis], ix);
+    return node[axis] != Trie::NONE && (!cell.is_end[axis] || cell.trie[axis]->isWordEnd(node[axis]));
+  });
+  if (!fits) return false;
+  //A word is identified by its length and terminal node; the few completed words are
+  //scanned linearly and dropped again in LIFO order by RemoveLetter
+  const int num_used = state.num_used;
+  const bool unique = AllAxes(cell, [&](int axis) {
+    if (!cell.unique_end[axis]) return true;
+    const uint64_t id = ((uint64_t)cell.length[axis] << 32) | node[axis];
+    for (int k = 0; k < state.num_used; ++k) {
+      if (state.used_words[k] == id) return false;
     }
+    state.used_words[state.num_used++] = id;
+    return true;
+  });
+  if (!unique) {
+    state.num_used = num_used;
+    return false;
   }
+  state.words[cell.pos] = (char)('A' + ix);
+  ForEachAxis(cell, [&](int axis) { state.nodes[axis][cell.pos] = node[axis]; });
+  state.tiles.add(ix);
+  if (untie) state.untied_pos = cell.pos;
+  return true;
+}
 
-  //Check if we have enough of each letter
-  int blanks_needed = 0;
-  for (const auto& pair : letter_count) {
-    char letter = pair.first;
-    int needed = pair.second;
+//Undo PlaceLetter when backtracking
+inline void RemoveLetter(int ix, const CellCursors& cur, SearchState& state) {
+  state.words[cur.cell->pos] = 0;
+  if (state.untied_pos == cur.cell->pos) state.untied_pos = -1;
+  ForEachAxis(*cur.cell, [&](int axis) {
+    if (cur.cell->unique_end[axis]) state.num_used--;
+  });
+  state.tiles.remove(ix);
+}
 
-    auto wordfeud_it = g_wordfeud_letters.find(letter);
-    if (wordfeud_it == g_wordfeud_letters.end()) {
-      //Letter not in WordFeud (shouldn't happen with our mapping)
-      blanks_needed += needed;
-    } else {
-      int available = wordfeud_it->second;
-      if (needed > available) {
-        blanks_needed += (needed - available);
-      }
+//Dynamic cell order (--order mcv). A cell is open when it is unfilled and the cells
+//before it in both of its segments are filled, so its trie cursors are known. Each
+//depth fills the open cell with the fewest candidate letters; placing a letter opens
+//the next cell of each of its segments once that cell's other predecessors are filled
+//too. The candidate mask of an open cell is computed once when it opens (its cursors
+//cannot change while it is open), and all updates are undone in LIFO order.
+
+//Add a cell to the open cells
+inline void OpenCell(int cell_ix, SearchState& state) {
+  state.open_cells[state.num_open] = cell_ix;
+  state.open_masks[state.num_open] = CandidateMask(GetCellCursors(cell_ix, state));
+  state.num_open++;
+}
+
+//Open the cells that start a segment on every axis
+void InitOpenCells(SearchState& state) {
+  state.num_open = 0;
+  if (!g_config.mcv_order) return;
+  for (int c = 0; c < (int)g_shape.cells.size(); ++c) {
+    bool is_open = true;
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+      is_open = is_open && g_shape.cells[c].prev[axis] < 0;
     }
+    if (is_open) OpenCell(c, state);
   }
+}
 
-  return blanks_needed <= g_wordfeud_blanks;
+//Choose the cell (index into g_shape.cells) to fill at depth i: cell i in row-major
+//order, or the open cell with the fewest letters still available
+inline int BeginDepth(int i, SearchState& state) {
+  if (!g_config.mcv_order) {
+    state.order[i] = i;
+    return i;
+  }
+#ifdef ENABLE_WORDFEUD_PRUNING
+  const uint32_t available = state.tiles.available();
+#else
+  const uint32_t available = Trie::LETTER_MASK;
+#endif
+  int best = 0;
+  int best_count = NUM_LETTERS + 1;
+  for (int slot = 0; slot < state.num_open; ++slot) {
+    const int count = __builtin_popcount(state.open_masks[slot] & available);
+    if (count < best_count || (count == best_count && state.open_cells[slot] < state.open_cells[best])) {
+      best = slot;
+      best_count = count;
+    }
+  }
+  //Move the last open cell into the chosen one's slot; EndDepth restores both
+  const int cell_ix = state.open_cells[best];
+  state.chosen_slot[i] = best;
+  state.chosen_mask[i] = state.open_masks[best];
+  state.num_open--;
+  state.open_cells[best] = state.open_cells[state.num_open];
+  state.open_masks[best] = state.open_masks[state.num_open];
+  state.order[i] = cell_ix;
+  return cell_ix;
 }
 
-//Check if a partial grid can potentially be played in WordFeud (for deepest position tracking)
-bool CanPotentiallyPlayInWordFeud(char* words, int current_pos) {
-  std::unordered_map<char, int> letter_count;
+//Undo BeginDepth
+inline void EndDepth(int i, SearchState& state) {
+  if (!g_config.mcv_order) return;
+  const int slot = state.chosen_slot[i];
+  state.open_cells[state.num_open] = state.open_cells[slot];
+  state.open_masks[state.num_open] = state.open_masks[slot];
+  state.open_cells[slot] = state.order[i];
+  state.open_masks[slot] = state.chosen_mask[i];
+  state.num_open++;
+}
 
-  //Count letters used so far (up to current_pos)
-  for (int pos = 0; pos <= current_pos; ++pos) {
-    if (IsValidPosition(pos) && words[pos] != 0) {
-      letter_count[words[pos]]++;
+//After a letter was placed in cell_ix at depth i, open the following cells it unblocks
+inline void OpenSuccessors(int i, int cell_ix, SearchState& state) {
+  if (!g_config.mcv_order) return;
+  const ShapeCell& cell = g_shape.cells[cell_ix];
+  int opened = 0;
+  for (int axis = 0; axis < NUM_AXES; ++axis) {
+    if (cell.next[axis] < 0) continue;
+    const int next_ix = g_shape.cell_index[cell.next[axis]];
+    bool is_open = true;
+    for (int other = 0; other < NUM_AXES; ++other) {
+      const int prev = g_shape.cells[next_ix].prev[other];
+      is_open = is_open && (other == axis || prev < 0 || state.words[prev] != 0);
+    }
+    if (is_open) {
+      OpenCell(next_ix, state);
+      opened++;
     }
   }
+  state.opened[i] = opened;
+}
 
-  //Check if current usage already exceeds WordFeud limits
-  int blanks_needed = 0;
-  for (const auto& pair : letter_count) {
-    char letter = pair.first;
-    int needed = pair.second;
+//Undo OpenSuccessors
+inline void CloseSuccessors(int i, SearchState& state) {
+  if (!g_config.mcv_order) return;
+  state.num_open -= state.opened[i];
+}
 
-    auto wordfeud_it = g_wordfeud_letters.find(letter);
-    if (wordfeud_it == g_wordfeud_letters.end()) {
-      blanks_needed += needed;
+//Append grid row h to out, with the internal letters mapped back to UTF-8 and
+//blocked positions shown as `blocked`
+void AppendGridRow(std::string& out, const char* words, int h, char blocked) {
+  for (int w = 0; w < g_config.width; ++w) {
+    if (g_shape_mask[h][w]) {
+      const char c = words[h * g_config.width + w];
+      if (c == 'Q') out += "\u00c5";
+      else if (c == 'W') out += "\u00c4";
+      else if (c == '[') out += "\u00d6";
+      else out += c;
     } else {
-      int available = wordfeud_it->second;
-      if (needed > available) {
-        blanks_needed += (needed - available);
+      out += blocked;
+    }
+  }
+}
+
+//Format a solution as a text block, or as a JSON object on one line:
+//{"grid":["ROW",...],"thread":N,"seconds":S,"combinations":N} with '.' for blocked cells
+void FormatSolution(std::string& out, const SearchState& state) {
+  const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - g_start_time).count();
+#ifdef ENABLE_THREADING
+  const uint64_t combinations = TotalCombinations();
+#else
+  const uint64_t combinations = g_combinations_tried;
+#endif
+  if (!g_config.jsonl) {
+    out += "*** SOLUTION FOUND (WordFeud compatible) ***\n";
+    for (int h = 0; h < g_config.height; ++h) {
+      AppendGridRow(out, state.words, h, ' ');
+      out += '\n';
+    }
+    out += '\n';
+    return;
+  }
+  out += "{\"grid\":[";
+  for (int h = 0; h < g_config.height; ++h) {
+    out += (h == 0) ? "\"" : ",\"";
+    AppendGridRow(out, state.words, h, '.');
+    out += '"';
+  }
+  char fields[128];
+  std::snprintf(fields, sizeof(fields), "],\"thread\":%d,\"seconds\":%.3f,\"combinations\":%llu}\n",
+                state.worker, seconds, (unsigned long long)combinations);
+  out += fields;
+}
+
+//Print a partially filled grid that reached a new deepest position ('_' = empty cell)
+void PrintDeepest(int reached, const char* words) {
+  std::cout << "New deepest WordFeud-compatible position: " << reached << std::endl;
+  std::cout << "Current grid state:" << std::endl;
+  for (int h = 0; h < g_config.height; ++h) {
+    for (int w = 0; w < g_config.width; ++w) {
+      if (g_shape_mask[h][w]) {
+        char ch = words[h * g_config.width + w];
+        if (ch == 0) std::cout << "_";
+        else std::cout << ch;
+      } else {
+        std::cout << " ";
       }
     }
+    std::cout << std::endl;
   }
+  std::cout << std::endl;
+}
 
-  return blanks_needed <= g_wordfeud_blanks;
+#ifdef ENABLE_THREADING
+//Publish a new deepest grid of this worker
+void PublishDeepest(WorkerStats& stats, int reached, const char* words) {
+  BeginSnapshot(stats);
+  stats.snapshot_deepest.store(reached, std::memory_order_relaxed);
+  for (int pos = 0; pos < g_config.width * g_config.height; ++pos) {
+    stats.deepest_grid[pos].store(words[pos], std::memory_order_relaxed);
+  }
+  EndSnapshot(stats);
 }
 
-//Check if partial word segments at this position are valid (prefix check)
-bool IsValidPartialSegments(int pos, char* words) {
-  int h = pos / SIZE_W;
-  int w = pos % SIZE_W;
+//Publish the letters of the first `depth` cells (in search order) being searched
+void PublishPrefix(WorkerStats& stats, const SearchState& state, int depth) {
+  const int length = std::min(depth, PROGRESS_PREFIX);
+  BeginSnapshot(stats);
+  stats.prefix_length.store(length, std::memory_order_relaxed);
+  for (int k = 0; k < length; ++k) {
+    stats.prefix[k].store(state.words[g_shape.cells[state.order[k]].pos], std::memory_order_relaxed);
+  }
+  EndSnapshot(stats);
+}
 
-  //Check horizontal word segments in this row
-  //Find all word segments in the row and validate each one
-  for (int start_w = 0; start_w < SIZE_W;) {
-    if (!IsValidPosition(h * SIZE_W + start_w)) {
-      start_w++;
-      continue;
-    }
+//Print the deepest grid of all workers if it beats `reported`, which is updated
+void ReportDeepest(int& reported) {
+  ProgressSnapshot snapshot;
+  ProgressSnapshot best;
+  best.deepest = reported;
+  for (unsigned int w = 0; w < g_num_workers; ++w) {
+    ReadSnapshot(g_worker_stats[w], snapshot);
+    if (snapshot.deepest > best.deepest) best = snapshot;
+  }
+  if (best.deepest <= reported) return;
+  reported = best.deepest;
+  std::lock_guard<std::mutex> lock(g_print_mutex);
+  PrintDeepest(best.deepest, best.deepest_grid);
+}
 
-    //Find the end of this segment
-    int end_w = start_w;
-    while (end_w < SIZE_W && IsValidPosition(h * SIZE_W + end_w)) {
-      end_w++;
-    }
-    end_w--; // Back to last valid position
+//Leading letters of each worker's current subtree, e.g. " ABC AD"
+std::string CurrentPrefixes() {
+  std::string prefixes;
+  ProgressSnapshot snapshot;
+  for (unsigned int w = 0; w < g_num_workers; ++w) {
+    ReadSnapshot(g_worker_stats[w], snapshot);
+    if (snapshot.prefix_length == 0) continue;
+    prefixes += ' ';
+    prefixes.append(snapshot.prefix, snapshot.prefix_length);
+  }
+  return prefixes;
+}
+#endif
 
-    //Validate all segments (including single letters)
-    if (end_w >= start_w) {
-      std::string h_word;
-      bool h_complete = true;
+//Record a solution if it is WordFeud compatible; with threads it is buffered for the writer
+void PrintBox(const SearchState& state) {
+  if (!CanPlayInWordFeud(state.words)) return;
+#ifdef ENABLE_THREADING
+  SolutionBuffer& buffer = g_solution_buffers[state.worker];
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  FormatSolution(buffer.text, state);
+#else
+  std::string text;
+  FormatSolution(text, state);
+  *g_solutions_out << text;
+#endif
+}
 
-      for (int col = start_w; col <= end_w; ++col) {
-        int row_pos = h * SIZE_W + col;
-        if (words[row_pos] == 0) {
-          h_complete = false;
-          break;
-        }
-        h_word += words[row_pos];
-      }
+#ifdef ENABLE_THREADING
+void PushTask(unsigned int worker, const SearchTask& task);
+void DonateWork(SearchState& state, int i);
+void SaveFrontier(SearchState& state, int i);
+void ParkForCheckpoint(SearchState& state, int i);
+void FlushSolutions();
+#endif
 
-      if (h_complete && h_word.length() >= 1) {
-        if (!g_trie_w.has(h_word)) {
-          return false;
-        }
-      } else if (!h_complete && h_word.length() > 0) {
-        //Check if partial word is a valid prefix for words of the expected segment length
-        int segment_length = end_w - start_w + 1;
-        if (segment_length >= 1 && g_tries_by_length.count(segment_length)) {
-          if (!g_tries_by_length[segment_length].hasPrefix(h_word)) {
-            return false;
-          }
-        }
-      }
-    }
+//Count a placement that filled the grid up to `reached` (see BoxSearch), and show the
+//grid if that is the deepest WordFeud-compatible position so far
+inline void CountCombination(int reached, SearchState& state) {
+  //Track deepest position reached (only if WordFeud compatible)
+#ifdef ENABLE_THREADING
+  WorkerStats& stats = g_worker_stats[state.worker];
+  if (reached > stats.deepest_pos && state.tiles.fits()) {
+    //Rare: a new record for this thread, published for the progress monitor
+    stats.deepest_pos = reached;
+    PublishDeepest(stats, reached, state.words);
+  }
+#else
+  if (reached > g_deepest_pos && state.tiles.fits()) {
+    g_deepest_pos = reached;
+    PrintDeepest(reached, state.words);
+  }
+#endif
 
-    start_w = end_w + 1;
+  //Count combinations tried and show progress
+#ifdef ENABLE_THREADING
+  //Single writer: a relaxed load/store pair avoids a locked read-modify-write
+  stats.combinations.store(stats.combinations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+#else
+  ++g_combinations_tried;
+  if (g_combinations_tried % 1000000 == 0) {
+    auto current_time = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds = std::chrono::duration<double>(current_time - g_start_time).count();
+    double combinations_per_second = g_combinations_tried / elapsed_seconds;
+    std::cout << "Combinations tried: " << g_combinations_tried
+              << " (" << std::fixed << std::setprecision(0) << combinations_per_second << " comb/sec)" << std::endl;
+
+    // No periodic flush in single-thread mode either during training
   }
+#endif
+}
 
-  //Check vertical word segments in this column
-  //Find all word segments in the column and validate each one
-  for (int start_h = 0; start_h < SIZE_H;) {
-    if (!IsValidPosition(start_h * SIZE_W + w)) {
-      start_h++;
-      continue;
+//Fill the cell of depth i (see BeginDepth) with letters from `allowed` and recurse into the following depths
+void BoxSearch(int i, SearchState& state, uint32_t allowed = Trie::LETTER_MASK) {
+  const int cell_ix = BeginDepth(i, state);
+  //Only try letters that continue both the row and the column prefix
+  const CellCursors cur = GetCellCursors(cell_ix, state);
+  const int pos = cur.cell->pos;
+  //Progress measure for the deepest-position report: the grid position in row-major
+  //order, the number of filled cells with --order mcv
+  const int reached = g_config.mcv_order ? i + 1 : pos;
+  //An open cell's candidates were computed when it opened
+  uint32_t candidates = (g_config.mcv_order ? state.chosen_mask[i] : CandidateMask(cur)) & allowed;
+#ifdef ENABLE_WORDFEUD_PRUNING
+  //Early pruning: never enter letters whose tiles (and blanks) are used up
+  candidates &= state.tiles.available();
+#endif
+  //Untried letters live in the state so idle threads can be handed a share of them
+  uint32_t& remaining = state.remaining[i];
+  remaining = candidates;
+  while (remaining != 0) {
+    //Safe point: every letter tried so far at each open level has been fully explored
+    if (g_exit_requested.load(std::memory_order_relaxed)) {
+#ifdef ENABLE_THREADING
+      SaveFrontier(state, i);
+#endif
+      // Stop exploring further; caller will unwind
+      break;
     }
-
-    //Find the end of this segment
-    int end_h = start_h;
-    while (end_h < SIZE_H && IsValidPosition(end_h * SIZE_W + w)) {
-      end_h++;
+#ifdef ENABLE_THREADING
+    if (g_checkpoint_requested.load(std::memory_order_relaxed)) {
+      ParkForCheckpoint(state, i);
     }
-    end_h--; // Back to last valid position
+#endif
+    const int ix = __builtin_ctz(remaining);
+    remaining &= remaining - 1;
+#ifdef ENABLE_THREADING
+    if (g_idle_workers.load(std::memory_order_relaxed) > g_queued_tasks.load(std::memory_order_relaxed)) {
+      DonateWork(state, i);
+    }
+#endif
+    //Advance the trie cursors; fails only if a completed segment is not a word
+    if (PlaceLetter(ix, cur, state)) {
+      OpenSuccessors(i, cell_ix, state);
+      CountCombination(reached, state);
 
-    //Validate all segments (including single letters)
-    if (end_h >= start_h) {
-      std::string v_word;
-      bool v_complete = true;
+      //Show progress: the leading letters of the subtree being searched
+#ifdef ENABLE_THREADING
+      if (i < PROGRESS_PREFIX) PublishPrefix(g_worker_stats[state.worker], state, i + 1);
+#else
+      if (i == 0) std::cout << "=== [" << (char)('A' + ix) << "] ===" << std::endl;
+#endif
 
-      for (int row = start_h; row <= end_h; ++row) {
-        int col_pos = row * SIZE_W + w;
-        if (words[col_pos] == 0) {
-          v_complete = false;
-          break;
-        }
-        v_word += words[col_pos];
+      //Check if we've reached the end
+      if (i + 1 == (int)g_shape.cells.size()) {
+        //No more positions; every segment ended on a word-end node, so the grid is complete
+        PrintBox(state);
+      } else {
+        //Continue to next position
+        BoxSearch(i + 1, state);
       }
 
-      Trie* trie_v = (SIZE_W != SIZE_H) ? &g_trie_h : &g_trie_w;
-      if (v_complete && v_word.length() >= 1) {
-        if (!trie_v->has(v_word)) {
-          return false;
-        }
-      } else if (!v_complete && v_word.length() > 0) {
-        //Check if partial word is a valid prefix for words of the expected segment length
-        int segment_length = end_h - start_h + 1;
-        if (segment_length >= 1 && g_tries_by_length.count(segment_length)) {
-          if (!g_tries_by_length[segment_length].hasPrefix(v_word)) {
-            return false;
-          }
-        }
-      }
+      //Clear the position when backtracking
+      CloseSuccessors(i, state);
+      RemoveLetter(ix, cur, state);
     }
+  }
+  EndDepth(i, state);
+}
 
-    start_h = end_h + 1;
+//Word engine (--engine word). Cells are filled in row-major order, but a row segment
+//gets a whole dictionary word at a time. The crossing prefixes of the segment's cells
+//are all complete when the segment starts, so each cell's crossing trie cursors give
+//the letters it may take; the words of the segment's trie that fit those masks are
+//enumerated with a walk over that one trie, and only a complete word is placed,
+//advancing every crossing cursor. Once placed, every later row segment whose crossing
+//prefixes became complete must still be able to take a word of its own.
+//The walk keeps its untried letters per cell in state.remaining like BoxSearch, so
+//tasks, work donation and checkpoints address the same subtrees in both engines.
+
+void WordSearch(int i, SearchState& state, uint32_t allowed = Trie::LETTER_MASK);
+
+//True if some word of the row trie takes a letter from masks[k] at every offset k
+bool RowHasWord(const Trie& trie, Trie::NodeIx node, const uint32_t* masks, int offset, int length) {
+  if (offset == length) return trie.isWordEnd(node);
+  uint32_t options = trie.childMask(node) & masks[offset];
+  while (options != 0) {
+    const int ix = __builtin_ctz(options);
+    options &= options - 1;
+    if (RowHasWord(trie, trie.decend(node, ix), masks, offset + 1, length)) return true;
   }
+  return false;
+}
 
+//Letters each cell first..last of a row segment may take given its crossing cursors
+//(and the tiles left); false if some cell can take none
+bool CrossingMasks(int first, int last, const SearchState& state, uint32_t* masks) {
+#ifdef ENABLE_WORDFEUD_PRUNING
+  const uint32_t available = state.tiles.available();
+#else
+  const uint32_t available = Trie::LETTER_MASK;
+#endif
+  for (int c = first; c <= last; ++c) {
+    const ShapeCell& cell = g_shape.cells[c];
+    uint32_t mask = available;
+    ForEachAxis(cell, [&](int axis) {
+      if (axis == AXIS_H) return;
+      const Trie& trie = *cell.trie[axis];
+      //Segment tries hold words of one length, so a child at a segment's last cell ends a word
+      mask &= trie.childMask((cell.prev[axis] < 0) ? trie.root() : state.nodes[axis][cell.prev[axis]]);
+    });
+    if (mask == 0) return false;
+    masks[c - first] = mask;
+  }
   return true;
 }
 
-//Validate all word segments in the completed grid
-bool ValidateAllSegments(char* words) {
-  //Check all horizontal segments (find separate word segments in each row)
-  for (int h = 0; h < SIZE_H; ++h) {
-    for (int start_w = 0; start_w < SIZE_W;) {
-      if (!IsValidPosition(h * SIZE_W + start_w)) {
-        start_w++;
-        continue;
+//Check the row segments that became ready while cells first..last were placed
+bool ReadyRowsFit(int first, int last, const SearchState& state) {
+  for (int c = first; c <= last; ++c) {
+    for (int seg : g_shape.ready_segments[c]) {
+      const Segment& segment = g_shape.segments[seg];
+      const int start = g_shape.cell_index[segment.start_pos];
+      if (start == last + 1) continue; //Searched next anyway
+      uint32_t masks[MAX_SIZE];
+      if (!CrossingMasks(start, start + segment.length - 1, state, masks) ||
+          !RowHasWord(*segment.trie, segment.trie->root(), masks, 0, segment.length)) {
+        return false;
       }
-
-      //Find the end of this segment
-      int end_w = start_w;
-      while (end_w < SIZE_W && IsValidPosition(h * SIZE_W + end_w)) {
-        end_w++;
-      }
-      end_w--; // Back to last valid position
-
-      //Validate all segments (including single letters)
-      if (end_w >= start_w) {
-        std::string word;
-        for (int col = start_w; col <= end_w; ++col) {
-          word += words[h * SIZE_W + col];
-        }
-        if (!g_trie_w.has(word)) {
-          return false;
-        }
-      }
-
-      start_w = end_w + 1;
     }
   }
+  return true;
+}
 
-  //Check all vertical segments (find separate word segments in each column)
-  Trie* trie_v = (SIZE_W != SIZE_H) ? &g_trie_h : &g_trie_w;
-  for (int w = 0; w < SIZE_W; ++w) {
-    for (int start_h = 0; start_h < SIZE_H;) {
-      if (!IsValidPosition(start_h * SIZE_W + w)) {
-        start_h++;
-        continue;
-      }
-
-      //Find the end of this segment
-      int end_h = start_h;
-      while (end_h < SIZE_H && IsValidPosition(end_h * SIZE_W + w)) {
-        end_h++;
-      }
-      end_h--; // Back to last valid position
-
-      //Validate all segments (including single letters)
-      if (end_h >= start_h) {
-        std::string word;
-        for (int row = start_h; row <= end_h; ++row) {
-          word += words[row * SIZE_W + w];
-        }
-        if (!trie_v->has(word)) {
-          return false;
-        }
-      }
-
-      start_h = end_h + 1;
+//Place the word spelled in state.words over cells first..last, advancing all cursors.
+//`placed` is set to the number of cells placed, which RemoveWord takes back even when
+//the word is rejected on the way (false).
+bool PlaceWord(int first, int last, SearchState& state, int& placed) {
+  for (placed = 0; first + placed <= last; ++placed) {
+    const int c = first + placed;
+    const int ix = state.words[g_shape.cells[c].pos] - 'A';
+    if (!PlaceLetter(ix, GetCellCursors(c, state), state)) return false;
+#ifdef ENABLE_WORDFEUD_PRUNING
+    //Early pruning: the word needs more tiles (and blanks) than are left
+    if (!state.tiles.fits()) {
+      placed++;
+      return false;
     }
+#endif
   }
-
   return true;
 }
 
-//Print a solution (thread-safe)
-void PrintBox(char* words) {
-  //Do a uniqueness check if requested
-  if (UNIQUE && SIZE_H == SIZE_W) {
-    for (int i = 0; i < SIZE_H; ++i) {
-      int num_same = 0;
-      for (int j = 0; j < SIZE_W; ++j) {
-        if (words[i * SIZE_W + j] == words[j * SIZE_W + i]) {
-          num_same += 1;
-        }
+//Undo the first `placed` cells of PlaceWord, keeping the word spelled for the walk
+void RemoveWord(int first, int placed, SearchState& state) {
+  for (int c = first + placed - 1; c >= first; --c) {
+    const int pos = g_shape.cells[c].pos;
+    const char letter = state.words[pos];
+    RemoveLetter(letter - 'A', GetCellCursors(c, state), state);
+    state.words[pos] = letter;
+  }
+}
+
+//Spell the letter of cell i of a row segment that started at cell `first` (or resumed
+//there from a task), walking the row trie from `node`. At the segment's last cell the
+//whole word is placed and the search moves on to the next segment.
+void SpellWord(int i, int first, int last, Trie::NodeIx node, const uint32_t* masks, SearchState& state, uint32_t allowed) {
+  const ShapeCell& cell = g_shape.cells[i];
+  const Trie& trie = *cell.trie[AXIS_H];
+  state.order[i] = i;
+  uint32_t& remaining = state.remaining[i];
+  remaining = trie.childMask(node) & masks[i - first] & allowed;
+  while (remaining != 0) {
+    //Safe point: every letter tried so far at each open level has been fully explored
+    if (g_exit_requested.load(std::memory_order_relaxed)) {
+#ifdef ENABLE_THREADING
+      SaveFrontier(state, i);
+#endif
+      break;
+    }
+#ifdef ENABLE_THREADING
+    if (g_checkpoint_requested.load(std::memory_order_relaxed)) {
+      ParkForCheckpoint(state, i);
+    }
+#endif
+    const int ix = __builtin_ctz(remaining);
+    remaining &= remaining - 1;
+#ifdef ENABLE_THREADING
+    if (g_idle_workers.load(std::memory_order_relaxed) > g_queued_tasks.load(std::memory_order_relaxed)) {
+      DonateWork(state, i);
+    }
+#endif
+    state.words[cell.pos] = (char)('A' + ix);
+    //Show progress: the leading letters of the subtree being searched
+#ifdef ENABLE_THREADING
+    if (i < PROGRESS_PREFIX) PublishPrefix(g_worker_stats[state.worker], state, i + 1);
+#else
+    if (i == 0) std::cout << "=== [" << (char)('A' + ix) << "] ===" << std::endl;
+#endif
+    if (i < last) {
+      SpellWord(i + 1, first, last, trie.decend(node, ix), masks, state, Trie::LETTER_MASK);
+      continue;
+    }
+    //A complete word: place it and search the rest of the grid
+    int placed = 0;
+    if (PlaceWord(first, last, state, placed)) {
+      CountCombination(cell.pos, state);
+      if (last + 1 == (int)g_shape.cells.size()) {
+        //Every segment ended on a word-end node, so the grid is complete
+        PrintBox(state);
+      } else if (ReadyRowsFit(first, last, state)) {
+        WordSearch(last + 1, state);
       }
-      if (num_same == SIZE_W) { return; }
     }
+    RemoveWord(first, placed, state);
   }
+  state.words[cell.pos] = 0;
+}
 
-  //Check WordFeud compatibility
-  bool wordfeud_compatible = CanPlayInWordFeud(words);
+//Fill the row segment of cell i with whole words, cell i taking letters from `allowed`.
+//Cell i is normally the first cell of the segment; a task may also start inside it,
+//with the cells before i already placed.
+void WordSearch(int i, SearchState& state, uint32_t allowed) {
+  const ShapeCell& cell = g_shape.cells[i];
+  const int last = i + cell.length[AXIS_H] - cell.offset[AXIS_H] - 1;
+  uint32_t masks[MAX_SIZE];
+  if (!CrossingMasks(i, last, state, masks)) return;
+  const Trie& trie = *cell.trie[AXIS_H];
+  const Trie::NodeIx node = (cell.prev[AXIS_H] < 0) ? trie.root() : state.nodes[AXIS_H][cell.prev[AXIS_H]];
+  SpellWord(i, i, last, node, masks, state, allowed);
+}
 
-  //Only print if WordFeud compatible
-  if (wordfeud_compatible) {
-    //Print result (with mutex protection in threaded mode)
 #ifdef ENABLE_THREADING
-    std::lock_guard<std::mutex> lock(g_print_mutex);
-#endif
-    std::cout << "*** SOLUTION FOUND (WordFeud compatible) ***" << std::endl;
-    //Print the full grid
-    for (int h = 0; h < SIZE_H; ++h) {
-      for (int w = 0; w < SIZE_W; ++w) {
-        if (g_shape_mask[h][w]) {
-          char c = words[h * SIZE_W + w];
-          // Reverse the mapping for output
-          if (c == 'Q') std::cout << "\u00c5"; // Q -> \u00c5
-          else if (c == 'W') std::cout << "\u00c4"; // W -> \u00c4
-          else if (c == '[') std::cout << "\u00d6"; // [ -> \u00d6
-          else std::cout << c;
-        } else {
-          std::cout << " "; // Empty space for blocked positions
-        }
-      }
-      std::cout << std::endl;
+//Queue a task on a worker's deque
+void PushTask(unsigned int worker, const SearchTask& task) {
+  g_pending_tasks++;
+  g_queued_tasks++;
+  std::lock_guard<std::mutex> lock(g_queues[worker].mutex);
+  g_queues[worker].tasks.push_back(task);
+}
+
+//Take the newest task from the worker's own deque, or steal the oldest task of another worker
+bool PopTask(unsigned int worker, SearchTask& task) {
+  for (unsigned int k = 0; k < g_num_workers; ++k) {
+    WorkQueue& queue = g_queues[(worker + k) % g_num_workers];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) continue;
+    if (k == 0) {
+      task = queue.tasks.back();
+      queue.tasks.pop_back();
+    } else {
+      task = queue.tasks.front();
+      queue.tasks.pop_front();
     }
-    std::cout << std::endl;
+    g_queued_tasks--;
+    return true;
   }
-  //If not WordFeud compatible, print nothing
+  return false;
 }
 
-void BoxSearch(int pos, char* words) {
-#ifdef ENABLE_PGO_FLUSH
-  // Check for requested graceful exit
-  if (g_exit_requested) {
-    // Unwind recursion and let threads return; main will flush once
+//Hand the untried letters of the shallowest open level (at most depth i) to idle workers
+void DonateWork(SearchState& state, int i) {
+  const int limit = std::min(i, MAX_SPLIT_DEPTH - 1);
+  for (int d = state.base_depth; d <= limit; ++d) {
+    if (state.remaining[d] == 0) continue;
+    SearchTask task;
+    task.depth = d;
+    task.mask = state.remaining[d];
+    for (int k = 0; k < d; ++k) {
+      task.letters[k] = state.words[g_shape.cells[state.order[k]].pos];
+    }
+    state.remaining[d] = 0;
+    g_donated_tasks++;
+    PushTask(state.worker, task);
     return;
   }
-#endif
-  //Skip invalid positions according to shape mask
-  if (!IsValidPosition(pos)) {
-    int next_pos = GetNextValidPosition(pos - 1);
-    if (next_pos == -1) {
-      //No more valid positions, we have a complete solution
-      PrintBox(words);
-      return;
+}
+
+//Append the unexplored part of the worker's current task, as seen from a safe point
+//at depth i, to `frontier`: the untried letters of every open level under its prefix
+void AppendFrontier(const SearchState& state, int i, std::vector<SearchTask>& frontier) {
+  for (int d = state.base_depth; d <= i; ++d) {
+    if (state.remaining[d] == 0) continue;
+    SearchTask task;
+    task.depth = d;
+    task.mask = state.remaining[d];
+    for (int k = 0; k < d; ++k) {
+      task.letters[k] = state.words[g_shape.cells[state.order[k]].pos];
     }
-    BoxSearch(next_pos, words);
-    return;
+    frontier.push_back(task);
   }
+}
 
-  //Try all possible letters at this position
-  for (char c = 'A'; c <= 'Z'; ++c) {
-#ifdef ENABLE_PGO_FLUSH
-    if (g_exit_requested) {
-      // Stop exploring further; caller will unwind
-      return;
+//Record the open levels once when the search is stopped; shallower frames just unwind
+void SaveFrontier(SearchState& state, int i) {
+  if (state.frontier_saved) return;
+  state.frontier_saved = true;
+  AppendFrontier(state, i, g_frontiers[state.worker]);
+}
+
+//Publish the worker's frontier and wait until main has written the checkpoint
+//(i = -1 for a worker between tasks)
+void ParkForCheckpoint(SearchState& state, int i) {
+  std::unique_lock<std::mutex> lock(g_checkpoint_mutex);
+  if (!g_checkpoint_requested) return;
+  std::vector<SearchTask>& frontier = g_frontiers[state.worker];
+  frontier.clear();
+  AppendFrontier(state, i, frontier);
+  const uint64_t generation = g_checkpoint_generation;
+  g_parked_workers++;
+  g_checkpoint_cv.notify_all();
+  g_checkpoint_cv.wait(lock, [generation] { return g_checkpoint_generation != generation; });
+  frontier.clear();
+}
+
+//Shape fingerprint stored in checkpoints so a run is never resumed on another grid
+std::string ShapeSignature() {
+  std::string signature = std::to_string(g_config.width) + "x" + std::to_string(g_config.height) + ":";
+  for (int h = 0; h < g_config.height; ++h) {
+    for (int w = 0; w < g_config.width; ++w) {
+      signature += g_shape_mask[h][w] ? '1' : '0';
     }
-#endif
-    words[pos] = c;
+  }
+  //Tasks name cells by depth, so they only replay under the same cell order and axes
+  if (g_config.mcv_order) signature += ":mcv";
+  if (g_config.diagonals) signature += ":diag";
+  return signature;
+}
 
-    //Check if current horizontal and vertical segments are valid so far
-    if (IsValidPartialSegments(pos, words)) {
+//Every setting besides the shape that changes which grids are searched or how they are
+//written, so a checkpoint is only resumed with exactly the settings and word list version
+//it was made with.
+//Files are identified by their size and modification time.
+std::string SearchOptions() {
+  auto file = [](const std::string& fname) {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (!Dictionary::stamp(fname, size, mtime)) return std::string("missing");
+    return std::to_string(size) + "@" + std::to_string(mtime);
+  };
+  std::string options = "dictionary=" + file(g_config.dictionary);
+  options += " unique=" + std::to_string(g_config.unique);
+  options += " symmetry=" + std::to_string(g_config.symmetry);
+  options += std::string(" format=") + (g_config.jsonl ? "jsonl" : "text");
 #ifdef ENABLE_WORDFEUD_PRUNING
-      //Early pruning: skip if this partial grid already exceeds WordFeud tile limits
-      if (!CanPotentiallyPlayInWordFeud(words, pos)) {
-        continue; //Skip this letter and try the next one
-      }
-#endif
-      //Track deepest position reached (only if WordFeud compatible)
-#ifdef ENABLE_THREADING
-      if (pos > g_deepest_pos && CanPotentiallyPlayInWordFeud(words, pos)) {
-        g_deepest_pos = pos;
-        std::lock_guard<std::mutex> lock(g_print_mutex);
-        std::cout << "New deepest WordFeud-compatible position: " << pos << std::endl;
-        std::cout << "Current grid state:" << std::endl;
-        for (int h = 0; h < SIZE_H; ++h) {
-          for (int w = 0; w < SIZE_W; ++w) {
-            if (g_shape_mask[h][w]) {
-              char ch = words[h * SIZE_W + w];
-              if (ch == 0) std::cout << "_";
-              else std::cout << ch;
-            } else {
-              std::cout << " ";
-            }
-          }
-          std::cout << std::endl;
-        }
-        std::cout << std::endl;
-      }
+  options += " wordfeud-pruning=1";
 #else
-      if (pos > g_deepest_pos && CanPotentiallyPlayInWordFeud(words, pos)) {
-        g_deepest_pos = pos;
-        std::cout << "New deepest WordFeud-compatible position: " << pos << std::endl;
-        std::cout << "Current grid state:" << std::endl;
-        for (int h = 0; h < SIZE_H; ++h) {
-          for (int w = 0; w < SIZE_W; ++w) {
-            if (g_shape_mask[h][w]) {
-              char ch = words[h * SIZE_W + w];
-              if (ch == 0) std::cout << "_";
-              else std::cout << ch;
-            } else {
-              std::cout << " ";
-            }
-          }
-          std::cout << std::endl;
-        }
-        std::cout << std::endl;
-      }
+  options += " wordfeud-pruning=0";
 #endif
-
-      //Count combinations tried and show progress
-#ifdef ENABLE_THREADING
-      uint64_t combinations = ++g_combinations_tried;
-      if (combinations % 10000000 == 0) {
-        std::lock_guard<std::mutex> lock(g_print_mutex);
-        auto current_time = std::chrono::high_resolution_clock::now();
-        auto elapsed_seconds = std::chrono::duration<double>(current_time - g_start_time).count();
-        double combinations_per_second = combinations / elapsed_seconds;
-        std::cout << "Combinations tried: " << combinations
-                  << " (" << std::fixed << std::setprecision(0) << combinations_per_second << " comb/sec)" << std::endl;
-
-        // No per-thread flush here; main will flush once at exit
-      }
-#else
-      ++g_combinations_tried;
-      if (g_combinations_tried % 1000000 == 0) {
-        auto current_time = std::chrono::high_resolution_clock::now();
-        auto elapsed_seconds = std::chrono::duration<double>(current_time - g_start_time).count();
-        double combinations_per_second = g_combinations_tried / elapsed_seconds;
-        std::cout << "Combinations tried: " << g_combinations_tried
-                  << " (" << std::fixed << std::setprecision(0) << combinations_per_second << " comb/sec)" << std::endl;
-
-        // No periodic flush in single-thread mode either during training
-      }
+#ifdef ENABLE_FREQ_FILTER
+  options += " min-freq-w=" + std::to_string(g_config.min_freq_w);
+  options += " min-freq-h=" + std::to_string(g_config.min_freq_h);
+  options += " freq-filter=" + file(g_config.freq_filter);
 #endif
+  return options;
+}
 
-      //Show progress (only for first position)
-      if (pos == GetNextValidPosition(-1)) {
-#ifdef ENABLE_THREADING
-        std::lock_guard<std::mutex> lock(g_print_mutex);
-#endif
-        std::cout << "=== [" << c << "] ===" << std::endl;
-      }
+//Write all queued tasks and worker frontiers to the checkpoint file; workers must be
+//parked or stopped. The file is replaced atomically. Returns the number of tasks.
+size_t WriteCheckpoint() {
+  std::vector<SearchTask> tasks;
+  for (unsigned int w = 0; w < g_num_workers; ++w) {
+    std::lock_guard<std::mutex> lock(g_queues[w].mutex);
+    tasks.insert(tasks.end(), g_queues[w].tasks.begin(), g_queues[w].tasks.end());
+  }
+  for (const std::vector<SearchTask>& frontier : g_frontiers) {
+    tasks.insert(tasks.end(), frontier.begin(), frontier.end());
+  }
 
-      //Check if we've reached the end
-      int next_pos = GetNextValidPosition(pos);
-      if (next_pos == -1) {
-        //No more positions, validate complete solution
-        if (ValidateAllSegments(words)) {
-          PrintBox(words);
-        }
-      } else {
-        //Continue to next position
-        BoxSearch(next_pos, words);
-      }
+  const std::string tmp_file = g_config.checkpoint_file + ".tmp";
+  {
+    std::ofstream fout(tmp_file);
+    fout << "wordsquares-checkpoint 1\n";
+    fout << "shape " << ShapeSignature() << "\n";
+    fout << "dictionary " << g_config.dictionary << "\n";
+    fout << "options " << SearchOptions() << "\n";
+    fout << "combinations " << (g_resumed_combinations + TotalCombinations()) << "\n";
+    fout << "tasks " << tasks.size() << "\n";
+    for (const SearchTask& task : tasks) {
+      fout << task.depth << " " << task.mask << " "
+           << (task.depth > 0 ? std::string(task.letters, task.depth) : std::string("-")) << "\n";
+    }
+    if (!fout) {
+      std::cerr << "Failed to write checkpoint " << tmp_file << std::endl;
+      return tasks.size();
     }
   }
-
-  //Clear the position when backtracking
-  words[pos] = 0;
+  if (std::rename(tmp_file.c_str(), g_config.checkpoint_file.c_str()) != 0) {
+    std::cerr << "Failed to replace checkpoint " << g_config.checkpoint_file << std::endl;
+  }
+  return tasks.size();
 }
 
-#ifdef ENABLE_THREADING
-//Thread worker function for parallel search
-void SearchWorker(char starting_letter, Trie* trie_h) {
-  //Each thread has its own word grid
-  char words[SIZE_H * SIZE_W] = { 0 };
+//Park every worker at a safe point, write the checkpoint and let them continue
+void CheckpointRunningSearch() {
+  std::unique_lock<std::mutex> lock(g_checkpoint_mutex);
+  g_checkpoint_requested = true;
+  g_checkpoint_cv.wait(lock, [] { return g_parked_workers == g_live_workers; });
+  if (g_live_workers > 0) {
+    //Solutions of the subtrees the checkpoint marks as done must reach the output first
+    FlushSolutions();
+    const size_t num_tasks = WriteCheckpoint();
+    std::lock_guard<std::mutex> print_lock(g_print_mutex);
+    std::cout << "Checkpoint written: " << num_tasks << " open subtrees" << std::endl;
+  }
+  g_parked_workers = 0;
+  g_checkpoint_generation++;
+  g_checkpoint_requested = false;
+  g_checkpoint_cv.notify_all();
+}
 
-  //Find the first valid position
-  int first_pos = GetNextValidPosition(-1);
-  if (first_pos == -1) return; // No valid positions
+//Read the frontier written by WriteCheckpoint; false if the file does not match this build
+bool LoadCheckpoint(std::vector<SearchTask>& tasks) {
+  std::ifstream fin(g_config.checkpoint_file);
+  std::string key, value;
+  size_t num_tasks = 0;
+  if (!(fin >> key >> value) || key != "wordsquares-checkpoint" || value != "1") return false;
+  if (!(fin >> key >> value) || key != "shape" || value != ShapeSignature()) return false;
+  if (!(fin >> key) || key != "dictionary" || !std::getline(fin >> std::ws, value) || value != g_config.dictionary) return false;
+  if (!(fin >> key) || key != "options" || !std::getline(fin >> std::ws, value) || value != SearchOptions()) return false;
+  if (!(fin >> key >> g_resumed_combinations) || key != "combinations") return false;
+  if (!(fin >> key >> num_tasks) || key != "tasks") return false;
+  for (size_t t = 0; t < num_tasks; ++t) {
+    SearchTask task;
+    std::string letters;
+    if (!(fin >> task.depth >> task.mask >> letters)) return false;
+    if (task.depth < 0 || task.depth > (int)g_shape.cells.size()) return false;
+    if (task.depth == 0 ? letters != "-" : (int)letters.size() != task.depth) return false;
+    for (int k = 0; k < task.depth; ++k) {
+      if (letters[k] < 'A' || letters[k] >= 'A' + NUM_LETTERS) return false;
+      task.letters[k] = letters[k];
+    }
+    tasks.push_back(task);
+  }
+  return true;
+}
 
-  //Set the first letter at the first valid position
-  words[first_pos] = starting_letter;
+//Rebuild the search state for a task's fixed cells and search the rest of its subtree
+//Tasks read from a checkpoint are replayed through the same trie checks, so a prefix
+//that is not valid for this dictionary is dropped instead of searched.
+void RunTask(const SearchTask& task, SearchState& state) {
+  int placed = 0;
+  while (placed < task.depth) {
+    const int cell_ix = BeginDepth(placed, state);
+    const int ix = task.letters[placed] - 'A';
+    if (ix < 0 || ix >= NUM_LETTERS || !PlaceLetter(ix, GetCellCursors(cell_ix, state), state)) {
+      EndDepth(placed, state);
+      break;
+    }
+    OpenSuccessors(placed, cell_ix, state);
+    placed++;
+  }
+  state.base_depth = task.depth;
+  if (placed == task.depth) PublishPrefix(g_worker_stats[state.worker], state, placed);
+  if (placed == task.depth && task.depth < (int)g_shape.cells.size()) {
+    if (g_config.word_engine) {
+      WordSearch(task.depth, state, task.mask);
+    } else {
+      BoxSearch(task.depth, state, task.mask);
+    }
+  } else if (placed == task.depth) {
+    PrintBox(state);
+  }
+  for (int k = placed - 1; k >= 0; --k) {
+    CloseSuccessors(k, state);
+    RemoveLetter(task.letters[k] - 'A', GetCellCursors(state.order[k], state), state);
+    EndDepth(k, state);
+  }
+}
 
+//Expand the search tree to split_depth fixed cells, collecting one task per valid prefix
+void GenerateTasks(int i, int split_depth, SearchState& state, std::vector<SearchTask>& tasks) {
+  if (i == split_depth) {
+    SearchTask task;
+    task.depth = i;
+    task.mask = Trie::LETTER_MASK;
+    for (int k = 0; k < i; ++k) {
+      task.letters[k] = state.words[g_shape.cells[state.order[k]].pos];
+    }
+    tasks.push_back(task);
+    return;
+  }
+  const int cell_ix = BeginDepth(i, state);
+  const CellCursors cur = GetCellCursors(cell_ix, state);
+  uint32_t candidates = CandidateMask(cur);
 #ifdef ENABLE_WORDFEUD_PRUNING
-  //Check if even the first letter exceeds WordFeud limits (very unlikely but possible)
-  if (!CanPotentiallyPlayInWordFeud(words, first_pos)) {
-    return; //Skip this starting letter entirely
+  candidates &= state.tiles.available();
+#endif
+  while (candidates != 0) {
+    const int ix = __builtin_ctz(candidates);
+    candidates &= candidates - 1;
+    if (PlaceLetter(ix, cur, state)) {
+      OpenSuccessors(i, cell_ix, state);
+      GenerateTasks(i + 1, split_depth, state, tasks);
+      CloseSuccessors(i, state);
+      RemoveLetter(ix, cur, state);
+    }
   }
+  EndDepth(i, state);
+}
+
+//Thread worker function for parallel search: run own tasks, steal when empty
+void SearchWorker(unsigned int worker) {
+  //Each thread has its own word grid and trie cursors
+  SearchState state;
+  state.worker = (int)worker;
+  SearchTask task;
+  bool idle = false;
+  while (!g_exit_requested.load(std::memory_order_relaxed)) {
+    if (g_checkpoint_requested.load(std::memory_order_relaxed)) {
+      ParkForCheckpoint(state, -1);
+    }
+    if (PopTask(worker, task)) {
+      if (idle) {
+        g_idle_workers--;
+        idle = false;
+      }
+      RunTask(task, state);
+      g_pending_tasks--;
+      continue;
+    }
+    if (g_pending_tasks.load() == 0) break;
+    if (!idle) {
+      g_idle_workers++;
+      idle = true;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  if (idle) g_idle_workers--;
+  std::lock_guard<std::mutex> lock(g_checkpoint_mutex);
+  g_live_workers--;
+  g_checkpoint_cv.notify_all();
+}
+
+//Move every worker's buffered solutions to the output
+void FlushSolutions() {
+  std::string text;
+  for (unsigned int w = 0; w < g_num_workers; ++w) {
+    SolutionBuffer& buffer = g_solution_buffers[w];
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    text += buffer.text;
+    buffer.text.clear();
+  }
+  if (text.empty()) return;
+  std::lock_guard<std::mutex> lock(g_print_mutex);
+  g_solutions_out->write(text.data(), (std::streamsize)text.size());
+  g_solutions_out->flush();
+}
+
+//Writer thread: flush the solution buffers periodically until stopped
+void SolutionWriter() {
+  std::unique_lock<std::mutex> lock(g_writer_mutex);
+  while (!g_writer_cv.wait_for(lock, std::chrono::milliseconds(SOLUTION_FLUSH_MS), [] { return g_writer_stop; })) {
+    lock.unlock();
+    FlushSolutions();
+    lock.lock();
+  }
+}
 #endif
 
-  {
-    std::lock_guard<std::mutex> lock(g_print_mutex);
-    std::cout << "=== [" << starting_letter << "] ===" << std::endl;
+//Print the command line help
+void Usage(const char* program) {
+  std::cout << "Usage: " << program << " [options]\n"
+            << "  --config FILE       Read options from FILE, one \"key value\" per line (keys as below, # comments)\n"
+            << "  --shape FILE        Shape mask, one row per line ('.', '0', '_' or ' ' = blocked, anything else = letter)\n"
+            << "  --row ROW           Append one row to the shape mask (mostly for config files)\n"
+            << "  --size WxH          Fill a full W x H rectangle (max " << MAX_SIZE << "x" << MAX_SIZE << ")\n"
+            << "  --dictionary FILE   Word list, one word per line, or a dictionary compiled by\n"
+            << "                      compile_dictionary (default " << DICTIONARY << ")\n"
+#ifdef ENABLE_FREQ_FILTER
+            << "  --freq-filter FILE  Word frequency CSV (default " << FREQ_FILTER << ")\n"
+            << "  --min-freq-w N      Keep only the top-N horizontal words (0 = all)\n"
+            << "  --min-freq-h N      Keep only the top-N vertical words (0 = all)\n"
+#endif
+            << "  --unique [BOOL]     Only print solutions with all unique words (square grids)\n"
+            << "  --diagonals [BOOL]  The two main diagonals must also be words (square grids)\n"
+            << "  --checkpoint FILE   Save the search frontier to FILE and resume from it\n"
+            << "  --format FORMAT     Solutions as text grids (default) or jsonl: one JSON object per\n"
+            << "                      line with the grid rows ('.' = blocked), thread, seconds and\n"
+            << "                      combinations tried so far\n"
+            << "  --solutions FILE    Write solutions to FILE (appended) instead of stdout\n"
+            << "  --order ORDER       Cell fill order: row (row-major, default) or mcv (open cell\n"
+            << "                      with the fewest candidate letters first)\n"
+            << "  --engine ENGINE     letter (default): fill one cell at a time, or word: place whole\n"
+            << "                      words in the row segments (row order only)\n"
+            << "  --symmetry [BOOL]   For a square shape equal to its transpose, print only one\n"
+            << "                      grid of each transposed pair (default on, row order only)\n"
+            << "Without --shape/--row/--size the built-in shape is searched." << std::endl;
+}
+
+//Parse a non-negative integer option
+bool ParseInt(const std::string& key, const std::string& value, int& out) {
+  char* end = nullptr;
+  const long n = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != 0 || n < 0) {
+    std::cerr << "Invalid number for " << key << ": " << value << std::endl;
+    return false;
   }
+  out = (int)n;
+  return true;
+}
 
-  //Start the search from the next valid position after first_pos
-  int next_pos = GetNextValidPosition(first_pos);
-  if (next_pos != -1) {
-    BoxSearch(next_pos, words);
-  } else {
-    //Only one position, validate and print if valid
-    if (ValidateAllSegments(words)) {
-      PrintBox(words);
+//Parse a boolean option (true/false, 1/0, yes/no)
+bool ParseBool(const std::string& key, const std::string& value, bool& out) {
+  if (value == "true" || value == "1" || value == "yes") { out = true; return true; }
+  if (value == "false" || value == "0" || value == "no") { out = false; return true; }
+  std::cerr << "Invalid boolean for " << key << ": " << value << std::endl;
+  return false;
+}
+
+//Read the shape mask rows from a text file
+bool LoadShapeFile(const std::string& fname) {
+  std::ifstream fin(fname);
+  if (!fin) {
+    std::cerr << "Cannot open shape file " << fname << std::endl;
+    return false;
+  }
+  g_config.shape_rows.clear();
+  std::string line;
+  while (std::getline(fin, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    g_config.shape_rows.push_back(line);
+  }
+  while (!g_config.shape_rows.empty() && g_config.shape_rows.back().empty()) {
+    g_config.shape_rows.pop_back();
+  }
+  return true;
+}
+
+bool ApplyOption(const std::string& key, const std::string& value);
+
+//Read "key value" (or "key = value") lines; the keys are the long options without "--"
+bool LoadConfigFile(const std::string& fname) {
+  std::ifstream fin(fname);
+  if (!fin) {
+    std::cerr << "Cannot open config file " << fname << std::endl;
+    return false;
+  }
+  std::string line;
+  while (std::getline(fin, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    const size_t key_start = line.find_first_not_of(" \t");
+    if (key_start == std::string::npos || line[key_start] == '#') continue;
+    const size_t key_end = line.find_first_of(" \t=", key_start);
+    const std::string key = line.substr(key_start, key_end - key_start);
+    std::string value;
+    if (key_end != std::string::npos) {
+      const size_t value_start = line.find_first_not_of(" \t=", key_end);
+      const size_t value_end = line.find_last_not_of(" \t");
+      if (value_start != std::string::npos) value = line.substr(value_start, value_end - value_start + 1);
     }
+    if (!ApplyOption(key, value.empty() ? "true" : value)) return false;
   }
+  return true;
 }
+
+//Apply one command line / config file option
+bool ApplyOption(const std::string& key, const std::string& value) {
+  if (key == "config") return LoadConfigFile(value);
+  if (key == "shape") return LoadShapeFile(value);
+  if (key == "row") {
+    g_config.shape_rows.push_back(value);
+    return true;
+  }
+  if (key == "size") {
+    int width = 0, height = 0;
+    const size_t x = value.find('x');
+    if (x == std::string::npos || !ParseInt(key, value.substr(0, x), width) || !ParseInt(key, value.substr(x + 1), height)) {
+      return false;
+    }
+    //Empty rows would read as "no shape given" and fall back to the built-in grid
+    if (width < 1 || height < 1) {
+      std::cerr << "Shape must be between 1x1 and " << MAX_SIZE << "x" << MAX_SIZE
+                << " (got " << width << "x" << height << ")" << std::endl;
+      return false;
+    }
+    g_config.shape_rows.assign(height, std::string(width, '1'));
+    return true;
+  }
+  if (key == "dictionary") { g_config.dictionary = value; return true; }
+#ifdef ENABLE_FREQ_FILTER
+  //Without ENABLE_FREQ_FILTER these keys are unknown, so a filter is never silently ignored
+  if (key == "freq-filter") { g_config.freq_filter = value; return true; }
+  if (key == "min-freq-w") return ParseInt(key, value, g_config.min_freq_w);
+  if (key == "min-freq-h") return ParseInt(key, value, g_config.min_freq_h);
 #endif
+  if (key == "unique") return ParseBool(key, value, g_config.unique);
+  if (key == "symmetry") return ParseBool(key, value, g_config.symmetry);
+  if (key == "diagonals") return ParseBool(key, value, g_config.diagonals);
+  if (key == "checkpoint") { g_config.checkpoint_file = value; return true; }
+  if (key == "solutions") { g_config.solutions_file = value; return true; }
+  if (key == "format") {
+    if (value != "text" && value != "jsonl") {
+      std::cerr << "Invalid solution format: " << value << " (text or jsonl)" << std::endl;
+      return false;
+    }
+    g_config.jsonl = (value == "jsonl");
+    return true;
+  }
+  if (key == "order") {
+    if (value != "row" && value != "mcv") {
+      std::cerr << "Invalid cell order: " << value << " (row or mcv)" << std::endl;
+      return false;
+    }
+    g_config.mcv_order = (value == "mcv");
+    return true;
+  }
+  if (key == "engine") {
+    if (value != "letter" && value != "word") {
+      std::cerr << "Invalid engine: " << value << " (letter or word)" << std::endl;
+      return false;
+    }
+    g_config.word_engine = (value == "word");
+    return true;
+  }
+  std::cerr << "Unknown option: " << key << " (see --help)" << std::endl;
+  return false;
+}
+
+//Replace the default shape mask with the configured rows, if any
+bool ApplyShapeRows() {
+  const std::vector<std::string>& rows = g_config.shape_rows;
+  if (rows.empty()) return true;
+  size_t width = 0;
+  for (const std::string& row : rows) {
+    width = std::max(width, row.size());
+  }
+  if (width == 0 || width > MAX_SIZE || rows.size() > MAX_SIZE) {
+    std::cerr << "Shape must be between 1x1 and " << MAX_SIZE << "x" << MAX_SIZE
+              << " (got " << width << "x" << rows.size() << ")" << std::endl;
+    return false;
+  }
+  g_config.width = (int)width;
+  g_config.height = (int)rows.size();
+  for (int h = 0; h < MAX_SIZE; ++h) {
+    for (int w = 0; w < MAX_SIZE; ++w) {
+      const char c = (h < g_config.height && w < (int)rows[h].size()) ? rows[h][w] : '.';
+      g_shape_mask[h][w] = !(c == '.' || c == '0' || c == '_' || c == ' ');
+    }
+  }
+  return true;
+}
 
 int main(int argc, char* argv[]) {
-#ifdef ENABLE_PGO_FLUSH
-  // Install signal handlers for graceful PGO flush on stop
+  // Install signal handlers for a graceful stop (final checkpoint, PGO flush)
   std::signal(SIGINT, HandleSignal);
   std::signal(SIGTERM, HandleSignal);
-#endif
+
+  //Read the runtime configuration
+  for (int a = 1; a < argc; ++a) {
+    const std::string arg = argv[a];
+    if (arg == "--help" || arg == "-h") {
+      Usage(argv[0]);
+      return 0;
+    }
+    if (arg.compare(0, 2, "--") != 0) {
+      Usage(argv[0]);
+      return 1;
+    }
+    //Flags may omit their value ("--unique")
+    std::string value = "true";
+    if (a + 1 < argc && std::strncmp(argv[a + 1], "--", 2) != 0) {
+      value = argv[++a];
+    }
+    if (!ApplyOption(arg.substr(2), value)) {
+      return 1;
+    }
+  }
+  if (!ApplyShapeRows()) {
+    return 1;
+  }
+  if (g_config.word_engine && g_config.mcv_order) {
+    std::cerr << "--engine word fills rows in order and cannot be combined with --order mcv" << std::endl;
+    return 1;
+  }
+  if (g_config.diagonals && g_config.width != g_config.height) {
+    std::cerr << "--diagonals needs a square grid" << std::endl;
+    return 1;
+  }
+  if (!g_config.solutions_file.empty()) {
+    g_solutions_file.open(g_config.solutions_file, std::ios::app);
+    if (!g_solutions_file) {
+      std::cerr << "Cannot open solutions file " << g_config.solutions_file << std::endl;
+      return 1;
+    }
+    g_solutions_out = &g_solutions_file;
+  }
 #ifdef ENABLE_FREQ_FILTER
   //Load word frequency list
-  LoadFreq(FREQ_FILTER);
+  LoadFreq(g_config.freq_filter.c_str());
 #endif
 
-  //Load words of all lengths needed for the shape
-  std::set<int> needed_lengths;
-  for (int h = 0; h < SIZE_H; ++h) {
-    int segment_length = 0;
-    for (int w = 0; w < SIZE_W; ++w) {
-      if (g_shape_mask[h][w]) {
-        segment_length++;
-      } else {
-        if (segment_length > 0) needed_lengths.insert(segment_length);
-        segment_length = 0;
-      }
-    }
-    if (segment_length > 0) needed_lengths.insert(segment_length);
+  //Precompute the shape topology once
+  CompileShape();
+  std::cout << "Grid " << g_config.width << "x" << g_config.height << " with "
+            << g_shape.cells.size() << " letters" << std::endl;
+  if (g_shape.transposed) {
+    std::cout << "Shape is its own transpose: printing only grids not greater than their transpose" << std::endl;
   }
 
-  for (int w = 0; w < SIZE_W; ++w) {
-    int segment_length = 0;
-    for (int h = 0; h < SIZE_H; ++h) {
-      if (g_shape_mask[h][w]) {
-        segment_length++;
-      } else {
-        if (segment_length > 0) needed_lengths.insert(segment_length);
-        segment_length = 0;
-      }
-    }
-    if (segment_length > 0) needed_lengths.insert(segment_length);
+  //Load words of all lengths needed for the shape
+  std::set<int> needed_lengths;
+  for (const Segment& segment : g_shape.segments) {
+    needed_lengths.insert(segment.length);
   }
 
   std::cout << "Loading words of lengths: ";
@@ -889,73 +1907,163 @@ int main(int argc, char* argv[]) {
   }
   std::cout << std::endl;
 
-  //Load all needed word lengths into both general tries and length-specific tries
-  for (int length : needed_lengths) {
-    LoadDictionary(DICTIONARY, length, g_trie_w, MIN_FREQ_W);
-    LoadDictionary(DICTIONARY, length, g_tries_by_length[length], MIN_FREQ_W);
+  //The shared dictionary holds every word, so the frequency filters and the banned
+  //list need the words read from a plain word list
+  bool filtered = !banned.empty();
+#ifdef ENABLE_FREQ_FILTER
+  filtered = filtered || g_config.min_freq_w > 0 || g_config.min_freq_h > 0;
+#endif
+  const bool compiled = Dictionary::isCompiled(g_config.dictionary);
+  if (compiled && filtered) {
+    std::cerr << "Word filters need a plain word list, not a compiled dictionary" << std::endl;
+    return 1;
   }
-
-  //For non-square grids, also load words into the vertical trie
-  if (SIZE_W != SIZE_H) {
+  if (!filtered) {
+    //Use the tries of the compiled dictionary, or of the word list's cache, in place
+    std::cout << "Opening dictionary " << g_config.dictionary << "..." << std::endl;
+    const auto start_time = std::chrono::steady_clock::now();
+    const bool square = (g_config.width == g_config.height);
+    bool opened = g_dictionary.open(g_config.dictionary);
     for (int length : needed_lengths) {
-      LoadDictionary(DICTIONARY, length, g_trie_h, MIN_FREQ_H);
+      opened = opened && g_dictionary.attach(length, g_tries_by_length[length]) &&
+               (square || g_dictionary.attach(length, g_tries_h_by_length[length]));
     }
+    if (!opened) {
+      std::cerr << "Cannot use dictionary " << g_config.dictionary << std::endl;
+      return 1;
+    }
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    std::cout << "Opened " << g_dictionary.numWords(0) << " words in "
+              << std::fixed << std::setprecision(1) << elapsed_ms << " ms." << std::endl;
+  } else {
+    //Read the word list once for all needed lengths
+    LoadDictionary(g_config.dictionary.c_str(), needed_lengths);
   }
 
-  Trie* trie_h = &g_trie_w;
+  size_t trie_nodes = 0;
+  for (auto& length_trie : g_tries_by_length) {
+    trie_nodes += length_trie.second.size();
+  }
+  for (auto& length_trie : g_tries_h_by_length) {
+    trie_nodes += length_trie.second.size();
+  }
+  std::cout << "Trie nodes: " << trie_nodes << " ("
+            << (trie_nodes * sizeof(Trie::Node)) / 1024 << " KB)" << std::endl;
+  AttachShapeTries();
 
 #ifdef ENABLE_THREADING
-  //Get available letters from the horizontal trie
-  std::vector<char> available_letters;
-  Trie::Iter iter = g_trie_w.iter();
-  while (iter.next()) {
-    available_letters.push_back(iter.getLetter());
+  //Determine number of threads
+  g_num_workers = std::max(1u, std::thread::hardware_concurrency());
+  g_queues.reset(new WorkQueue[g_num_workers]);
+
+  g_frontiers.resize(g_num_workers);
+  g_worker_stats.reset(new WorkerStats[g_num_workers]);
+  g_solution_buffers.reset(new SolutionBuffer[g_num_workers]);
+
+  //Resume the open subtrees of an earlier run, or split the search tree into initial tasks
+  std::vector<SearchTask> tasks;
+  if (!g_config.checkpoint_file.empty() && std::ifstream(g_config.checkpoint_file).good()) {
+    if (!LoadCheckpoint(tasks)) {
+      std::cerr << "Checkpoint " << g_config.checkpoint_file << " is invalid or was written for another shape, dictionary or options" << std::endl;
+      return 1;
+    }
+    std::cout << "Resuming from checkpoint " << g_config.checkpoint_file << " (" << g_resumed_combinations
+              << " combinations tried in earlier runs)" << std::endl;
+  } else {
+    SearchState state;
+    const int split_depth = std::min(SPLIT_DEPTH, (int)g_shape.cells.size());
+    GenerateTasks(0, split_depth, state, tasks);
+  }
+  //Deal the tasks out round-robin
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    PushTask(i % g_num_workers, tasks[i]);
   }
 
-  //Determine number of threads (limit to hardware concurrency)
-  const unsigned int num_threads = std::min(std::thread::hardware_concurrency(),
-                                           static_cast<unsigned int>(available_letters.size()));
-
-  std::cout << "Starting parallel search with " << num_threads << " threads processing "
-            << available_letters.size() << " starting letters..." << std::endl;
+  std::cout << "Starting parallel search with " << g_num_workers << " threads processing "
+            << tasks.size() << " initial tasks..." << std::endl;
 
   //Initialize timing for combinations per second tracking
   g_start_time = std::chrono::high_resolution_clock::now();
   g_last_report_time = g_start_time;
 
-  //Work queue and synchronization
-  std::atomic<size_t> work_index(0);
-
-  //Worker function that processes multiple letters per thread
-  auto worker = [&]() {
-    size_t index;
-    while ((index = work_index.fetch_add(1)) < available_letters.size()) {
-      SearchWorker(available_letters[index], trie_h);
-    }
-  };
-
   //Create and launch threads
   std::vector<std::thread> threads;
-  for (unsigned int i = 0; i < num_threads; ++i) {
-    threads.emplace_back(worker);
+  g_live_workers = (int)g_num_workers;
+  for (unsigned int i = 0; i < g_num_workers; ++i) {
+    threads.emplace_back(SearchWorker, i);
+  }
+  std::thread writer(SolutionWriter);
+
+  //Monitor: render the workers' snapshots and checkpoint periodically until the workers
+  //finish or are stopped by a signal. New deepest grids are shown at most once per tick.
+  auto next_checkpoint = std::chrono::steady_clock::now() + std::chrono::seconds(CHECKPOINT_INTERVAL);
+  uint64_t last_report_combinations = 0;
+  int reported_deepest = -1;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(g_checkpoint_mutex);
+      if (g_checkpoint_cv.wait_for(lock, std::chrono::milliseconds(200), [] { return g_live_workers == 0; })) break;
+    }
+    ReportDeepest(reported_deepest);
+    auto current_time = std::chrono::high_resolution_clock::now();
+    double interval_seconds = std::chrono::duration<double>(current_time - g_last_report_time).count();
+    if (interval_seconds >= REPORT_INTERVAL) {
+      const uint64_t combinations = TotalCombinations();
+      double combinations_per_second = (combinations - last_report_combinations) / interval_seconds;
+      const std::string prefixes = CurrentPrefixes();
+      std::lock_guard<std::mutex> lock(g_print_mutex);
+      std::cout << "Combinations tried: " << combinations
+                << " (" << std::fixed << std::setprecision(0) << combinations_per_second << " comb/sec)"
+                << (prefixes.empty() ? "" : ", searching") << prefixes << std::endl;
+      last_report_combinations = combinations;
+      g_last_report_time = current_time;
+    }
+    if (!g_config.checkpoint_file.empty() && !g_exit_requested.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() >= next_checkpoint) {
+      CheckpointRunningSearch();
+      next_checkpoint = std::chrono::steady_clock::now() + std::chrono::seconds(CHECKPOINT_INTERVAL);
+    }
   }
 
   //Wait for all threads to complete
   for (auto& thread : threads) {
     thread.join();
   }
+  {
+    std::lock_guard<std::mutex> lock(g_writer_mutex);
+    g_writer_stop = true;
+  }
+  g_writer_cv.notify_all();
+  writer.join();
+  FlushSolutions();
+  ReportDeepest(reported_deepest);
+  std::cout << "Tasks donated to idle threads: " << g_donated_tasks << std::endl;
+
+  //Stopped workers left their open subtrees in g_frontiers; a finished search leaves none
+  if (!g_config.checkpoint_file.empty()) {
+    if (g_exit_requested.load(std::memory_order_relaxed) && WriteCheckpoint() > 0) {
+      std::cout << "Stopped. Resume with --checkpoint " << g_config.checkpoint_file << std::endl;
+    } else {
+      std::remove(g_config.checkpoint_file.c_str());
+    }
+  }
 
   auto end_time = std::chrono::high_resolution_clock::now();
   auto total_seconds = std::chrono::duration<double>(end_time - g_start_time).count();
-  double avg_combinations_per_second = g_combinations_tried / total_seconds;
-  std::cout << "Done. Total combinations tried: " << g_combinations_tried
-            << " (avg " << std::fixed << std::setprecision(0) << avg_combinations_per_second << " comb/sec)" << std::endl;
+  const uint64_t total_combinations = TotalCombinations();
+  double avg_combinations_per_second = total_combinations / total_seconds;
+  //A resumed run counts the combinations of the earlier runs too, as its checkpoint does
+  std::cout << "Done. Total combinations tried: " << (g_resumed_combinations + total_combinations)
+            << " (" << total_combinations << " in this run, avg " << std::fixed << std::setprecision(0)
+            << avg_combinations_per_second << " comb/sec)" << std::endl;
 #ifdef ENABLE_PGO_FLUSH
   // Single flush at end of run (after threads stop)
   if (__gcov_flush) __gcov_flush();
 #endif
 #else
   //Single-threaded search
+  if (!g_config.checkpoint_file.empty()) {
+    std::cerr << "Checkpointing requires ENABLE_THREADING; running without it" << std::endl;
+  }
   std::cout << "Starting single-threaded search..." << std::endl;
 
   //Initialize timing for combinations per second tracking
@@ -963,16 +2071,19 @@ int main(int argc, char* argv[]) {
   g_last_report_time = g_start_time;
 
   //Initialize word grid
-  char words[SIZE_H * SIZE_W] = { 0 };
+  SearchState state;
 
   //Start the search from the first valid position
-  int first_pos = GetNextValidPosition(-1);
-  if (first_pos != -1) {
-    BoxSearch(first_pos, words);
+  if (!g_shape.cells.empty() && g_config.word_engine) {
+    WordSearch(0, state);
+  } else if (!g_shape.cells.empty()) {
+    BoxSearch(0, state);
   } else {
     std::cout << "No valid positions in shape mask!" << std::endl;
   }
 
+  g_solutions_out->flush();
+
   auto end_time = std::chrono::high_resolution_clock::now();
   auto total_seconds = std::chrono::duration<double>(end_time - g_start_time).count();
   double avg_combinations_per_second = g_combinations_tried / total_seconds;
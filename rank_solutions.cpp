@@ -1,4 +1,5 @@
 #include "trie.h"
+#include "dictionary.h"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -12,8 +13,9 @@
 #define DICTIONARY "WordFeud_ordlista.txt"
 #define OUTPUT_FILE "output.txt"
 
-// Global dictionary
-Trie g_word_trie;
+// Global dictionary and its 2-8 letter words
+Dictionary g_dictionary;
+WordView g_words;
 
 // Structure to hold a solution and its metrics
 struct Solution {
@@ -23,53 +25,6 @@ struct Solution {
     std::vector<std::string> words;
 };
 
-// Load dictionary
-void LoadDictionary(const char* fname) {
-    std::cout << "Loading WordFeud dictionary..." << std::endl;
-    int num_words = 0;
-    std::ifstream fin(fname);
-    std::string line;
-    
-    while (std::getline(fin, line)) {
-        // Remove carriage return if present
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-        
-        // Handle UTF-8 Swedish characters and convert to uppercase
-        std::string processed_line;
-        for (size_t i = 0; i < line.size(); ++i) {
-            unsigned char c = line[i];
-            if (c >= 'a' && c <= 'z') {
-                processed_line += (c - 'a' + 'A');
-            } else if (c == 0xC3 && i + 1 < line.size()) {
-                unsigned char next = line[i + 1];
-                if (next == 0x85) { // Å
-                    processed_line += 'Q';
-                    ++i; // Skip next byte
-                } else if (next == 0x84) { // Ä
-                    processed_line += 'W';
-                    ++i; // Skip next byte
-                } else if (next == 0x96) { // Ö
-                    processed_line += '[';
-                    ++i; // Skip next byte
-                } else {
-                    processed_line += c;
-                }
-            } else if (c >= 'A' && c <= 'Z') {
-                processed_line += c;
-            }
-        }
-        
-        line = processed_line;
-        if (line.size() >= 2 && line.size() <= 8) { // 2-8 letter words
-            g_word_trie.add(line);
-            num_words++;
-        }
-    }
-    std::cout << "Loaded " << num_words << " words." << std::endl;
-}
-
 // Extract all words from a grid (horizontal and vertical)
 std::vector<std::string> ExtractWords(const std::vector<std::string>& grid) {
     std::vector<std::string> words;
@@ -122,7 +77,7 @@ std::vector<std::string> ExtractSubWords(const std::string& word) {
     for (size_t start = 0; start < word.length(); ++start) {
         for (size_t len = 2; len <= word.length() - start; ++len) {
             std::string sub = word.substr(start, len);
-            if (g_word_trie.has(sub)) {
+            if (g_words.has(sub)) {
                 subwords.push_back(sub);
             }
         }
@@ -312,8 +267,12 @@ void PrintSolution(const Solution& solution, int rank) {
 }
 
 int main(int argc, char* argv[]) {
-    // Load dictionary
-    LoadDictionary(DICTIONARY);
+    // Load dictionary (served from the cache built by any of the programs)
+    if (!g_dictionary.open(DICTIONARY)) {
+        return 1;
+    }
+    g_words = g_dictionary.view(2, GRID_SIZE);
+    std::cout << "Loaded " << g_dictionary.numWords(0) << " words." << std::endl;
     
     // Parse solutions
     std::vector<Solution> solutions = ParseSolutions(OUTPUT_FILE);
@@ -3,65 +3,98 @@
 #include <iostream>
 
 Trie::Trie() {
-  std::fill(nodes, nodes + NUM_LETTERS, nullptr);
-  is_word_end = false;
-}
-
-Trie::~Trie() {
-  Iter i = iter();
-  while (i.next()) { delete i.get(); }
+  m_build.emplace_back();
+  m_build.back().fill(0);
+  m_build_end.push_back(false);
 }
 
 void Trie::add(const std::string& str) {
-  Trie* ptr = this;
+  assert(!m_build.empty() && "Trie::add called after finalize()");
+  uint32_t ptr = 0;
   for (char c : str) {
     const int ix = c - 'A';
     if (ix < 0 || ix >= NUM_LETTERS) {
       std::cerr << "Invalid character '" << c << "' (code " << (int)c << ") in word: " << str << std::endl;
     }
     assert(ix >= 0 && ix < NUM_LETTERS);
-    if (ptr->nodes[ix] == nullptr) {
-      ptr->nodes[ix] = new Trie();
+    if (m_build[ptr][ix] == 0) {
+      m_build[ptr][ix] = (uint32_t)m_build.size();
+      m_build.emplace_back();
+      m_build.back().fill(0);
+      m_build_end.push_back(false);
     }
-    ptr = ptr->nodes[ix];
+    ptr = m_build[ptr][ix];
   }
-  ptr->is_word_end = true;
+  m_build_end[ptr] = true;
 }
 
-bool Trie::has(const std::string& str) const {
-  if (str.empty()) return false;
-  
-  const Trie* ptr = this;
-  for (char c : str) {
-    const int ix = c - 'A';
-    if (ix < 0 || ix >= NUM_LETTERS) {
-      return false; // Invalid character
-    }
-    if (ptr->nodes[ix] == nullptr) {
-      return false;
-    } else {
-      ptr = ptr->nodes[ix];
+void Trie::finalize() {
+  if (m_build.empty()) return;
+
+  //Lay out nodes breadth-first so siblings are contiguous and the hot top levels share cache lines
+  std::vector<uint32_t> order;
+  order.reserve(m_build.size());
+  order.push_back(0);
+  m_nodes.clear();
+  m_nodes.reserve(m_build.size());
+  m_nodes.push_back(Node{ 0, 0 });
+  for (size_t i = 0; i < order.size(); ++i) {
+    const std::array<uint32_t, NUM_LETTERS>& children = m_build[order[i]];
+    uint32_t mask = m_build_end[order[i]] ? WORD_END_BIT : 0;
+    const uint32_t first_child = (uint32_t)m_nodes.size();
+    for (int ix = 0; ix < NUM_LETTERS; ++ix) {
+      if (children[ix] != 0) {
+        mask |= 1u << ix;
+        order.push_back(children[ix]);
+        m_nodes.push_back(Node{ 0, 0 });
+      }
     }
+    m_nodes[i] = Node{ mask, first_child };
   }
-  return ptr->is_word_end;
+  m_data = m_nodes.data();
+  m_size = m_nodes.size();
+
+  //Release the build structure
+  std::vector<std::array<uint32_t, NUM_LETTERS>>().swap(m_build);
+  std::vector<bool>().swap(m_build_end);
 }
 
-bool Trie::hasPrefix(const std::string& str) const {
-  if (str.empty()) return true;
-  
-  const Trie* ptr = this;
+void Trie::attach(const Node* nodes, size_t count) {
+  assert(count > 0 && "Trie::attach needs at least the root node");
+  std::vector<std::array<uint32_t, NUM_LETTERS>>().swap(m_build);
+  std::vector<bool>().swap(m_build_end);
+  std::vector<Node>().swap(m_nodes);
+  m_data = nodes;
+  m_size = count;
+}
+
+Trie::NodeIx Trie::walk(const std::string& str) const {
+  assert(m_size != 0 && "Trie queried before finalize()");
+  NodeIx ptr = root();
   for (char c : str) {
     const int ix = c - 'A';
     if (ix < 0 || ix >= NUM_LETTERS) {
-      return false; // Invalid character
+      return NONE; // Invalid character
     }
-    if (ptr->nodes[ix] == nullptr) {
-      return false;
-    } else {
-      ptr = ptr->nodes[ix];
+    ptr = decend(ptr, ix);
+    if (ptr == NONE) {
+      return NONE;
     }
   }
+  return ptr;
+}
+
+bool Trie::has(const std::string& str) const {
+  if (str.empty()) return false;
+
+  const NodeIx ptr = walk(str);
+  return ptr != NONE && isWordEnd(ptr);
+}
+
+bool Trie::hasPrefix(const std::string& str) const {
+  if (str.empty()) return true;
+
   //For prefix check, we just need to reach the end of the string
   //We don't need to check if it's a complete word
-  return true;
+  return walk(str) != NONE;
 }
@@ -1,41 +1,89 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <string>
+#include <vector>
 #define NUM_LETTERS 27
 
-
+//Compact trie stored as one contiguous node array.
+//Each node is 8 bytes: a child-presence bitmask (bit NUM_LETTERS marks a word end)
+//and the index of its first child. Children of a node are stored consecutively in
+//letter order, so child ix lives at first_child + popcount(mask bits below ix).
+//Words are added to a temporary build structure; finalize() packs it in BFS order
+//and must be called before the trie is queried. Alternatively attach() points the
+//trie at an already packed node array owned elsewhere (e.g. a memory-mapped file).
 class Trie {
 public:
+  typedef uint32_t NodeIx;
+  static const NodeIx NONE = 0xFFFFFFFFu;
+  static const uint32_t WORD_END_BIT = 1u << NUM_LETTERS;
+  static const uint32_t LETTER_MASK = WORD_END_BIT - 1;
+
+  struct Node {
+    uint32_t mask;
+    uint32_t first_child;
+  };
+
   class Iter {
   public:
-    Iter(Trie** nodes) : n(nodes), ix(-1) {}
+    Iter(const Node& node) : bits(node.mask & LETTER_MASK), child(node.first_child - 1), ix(-1) {}
     inline int getIx() const { return ix; }
     inline char getLetter() const { return (char)(ix + 'A'); }
-    inline Trie* get() const { return n[ix]; }
+    inline NodeIx get() const { return child; }
     bool next() {
-      while (true) {
-        ix += 1;
-        if (ix >= NUM_LETTERS) { return false; }
-        if (n[ix] != nullptr) { return true; }
-      }
+      if (bits == 0) { return false; }
+      ix = __builtin_ctz(bits);
+      bits &= bits - 1;
+      child += 1;
+      return true;
     }
 
   private:
+    uint32_t bits;
+    NodeIx child;
     int ix;
-    Trie** n;
   };
 
   Trie();
-  ~Trie();
+  Trie(const Trie&) = delete;
+  Trie& operator=(const Trie&) = delete;
+  Trie(Trie&&) = default;
+  Trie& operator=(Trie&&) = default;
 
   void add(const std::string& str);
+  void finalize();
+  //Use `count` packed nodes stored elsewhere; they must outlive the trie
+  void attach(const Node* nodes, size_t count);
   bool has(const std::string& str) const;
   bool hasPrefix(const std::string& str) const;
-  inline bool hasIx(int ix) const { return nodes[ix] != nullptr; }
-  inline bool hasLetter(char c) const { return nodes[int(c - 'A')] != nullptr; }
-  inline Trie* decend(int ix) const { return nodes[ix]; }
 
-  Iter iter() { return Iter(nodes); }
+  inline NodeIx root() const { return 0; }
+  inline uint32_t childMask(NodeIx n) const { return m_data[n].mask & LETTER_MASK; }
+  inline bool isWordEnd(NodeIx n) const { return (m_data[n].mask & WORD_END_BIT) != 0; }
+  inline bool hasIx(NodeIx n, int ix) const { return (m_data[n].mask >> ix) & 1; }
+  inline bool hasLetter(NodeIx n, char c) const { return hasIx(n, int(c - 'A')); }
+  //Child of node n for letter ix, or NONE
+  inline NodeIx decend(NodeIx n, int ix) const {
+    const Node& node = m_data[n];
+    if (!((node.mask >> ix) & 1)) { return NONE; }
+    return node.first_child + __builtin_popcount(node.mask & ((1u << ix) - 1));
+  }
+  //Number of packed nodes (0 before finalize)
+  inline size_t size() const { return m_size; }
+  //The packed node array, e.g. for serialization
+  inline const Node* data() const { return m_data; }
+
+  Iter iter(NodeIx n) const { return Iter(m_data[n]); }
+  Iter iter() const { return iter(root()); }
+
+private:
+  NodeIx walk(const std::string& str) const;
 
-  Trie* nodes[NUM_LETTERS];
-  bool is_word_end = false;
+  std::vector<Node> m_nodes;
+  //Packed nodes in use: m_nodes after finalize(), or external storage after attach()
+  const Node* m_data = nullptr;
+  size_t m_size = 0;
+  //Build-time nodes, one child slot per letter (0 = no child, since the root is never a child)
+  std::vector<std::array<uint32_t, NUM_LETTERS>> m_build;
+  std::vector<bool> m_build_end;
 };
@@ -1,15 +1,18 @@
 #include "trie.h"
+#include "dictionary.h"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <vector>
 #include <string>
-#include <set>
 #include <unordered_set>
 #include <algorithm>
 #include <sstream>
 #include <chrono>
-#include <queue>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
 
 // Grid dimensions (15x15 for WordFeud)
 #define GRID_SIZE 15
@@ -23,15 +26,46 @@
 // Output file path
 #define OUTPUT_FILE "planner_output.txt"
 
+// Zobrist keys per square cover the internal letters 'A'..'[' ('[' is Ö)
+#define ZOBRIST_LETTERS 32
+
+// Most tiles a single play can place (a full rack)
+#define MAX_PLAY 7
+
+// Most reverse plays searched from the input board
+#define MAX_DEPTH 100
+
+// The boards this many plays below the input are the tasks the threads share
+#define SPLIT_DEPTH 2
+
+// Transposition table size: 2^DEAD_END_BITS entries of 8 bytes (32 MB), in buckets of
+// DEAD_END_WAYS entries that share one cache line
+#define DEAD_END_BITS 22
+#define DEAD_END_WAYS 4
+
 // Global variables
-Trie g_word_trie;
+Dictionary g_dictionary;
+WordView g_words;   // 1-15 letter words for WordFeud (including long words)
 std::ofstream output_file;
-int g_deepest_reached = -1;
-uint64_t g_combinations_tried = 0;
+std::atomic<int> g_deepest_reached(-1);
+std::mutex g_deepest_mutex;                      // Held while reporting a new deepest board
+std::atomic<uint64_t> g_combinations_tried(0);   // Progress total, added to in batches
+std::atomic<bool> g_solved(false);               // Set by the thread finding a target; stops the others
 std::chrono::high_resolution_clock::time_point g_start_time;
 
+// Transposition table of boards the search has already failed to reduce, shared by
+// the threads. Its size is fixed: the low hash bits pick a bucket, and each entry is
+// one atomic word holding the high 32 hash bits as a check key, the move budget the
+// board was searched with and the most moves reached below it. An empty entry is 0
+// (stored budgets are at least 1).
+alignas(64) std::atomic<uint64_t> g_dead_ends[1 << DEAD_END_BITS];
+uint64_t g_zobrist[GRID_SIZE][GRID_SIZE][ZOBRIST_LETTERS];
+
+std::mutex g_output_mutex;
+
 // Helper function to output to both console and file
 void output(const std::string& text) {
+    std::lock_guard<std::mutex> lock(g_output_mutex);
     std::cout << text;
     std::cout.flush();
     if (output_file.is_open()) {
@@ -42,62 +76,107 @@ void output(const std::string& text) {
 std::vector<std::string> g_grid;
 std::pair<int, int> g_starting_square = {-1, -1};
 
-// Structure to represent a game state
-struct GameState {
-    std::vector<std::string> grid;
-    std::vector<std::string> play_sequence;
-    int moves_count = 0;
-    
-    GameState() : grid(GRID_SIZE, std::string(GRID_SIZE, ' ')) {}
-    GameState(const std::vector<std::string>& g) : grid(g), moves_count(0) {}
+// Fill the Zobrist keys from a fixed seed so hashes are the same on every run
+void InitZobrist() {
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (int row = 0; row < GRID_SIZE; ++row) {
+        for (int col = 0; col < GRID_SIZE; ++col) {
+            for (int l = 0; l < ZOBRIST_LETTERS; ++l) {
+                // splitmix64
+                uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                g_zobrist[row][col][l] = z ^ (z >> 31);
+            }
+        }
+    }
+}
+
+// Key of a letter on a square; XOR it in or out as the letter is placed or removed
+inline uint64_t ZobristKey(int row, int col, char c) {
+    return g_zobrist[row][col][(c - 'A') & (ZOBRIST_LETTERS - 1)];
+}
+
+// A reverse play: tiles taken off one row or column
+struct Move {
+    uint8_t line;              // Row or column index
+    bool vertical;             // Tiles of a column
+    uint16_t cells;            // Bit i set for square i along the line
+    char letters[MAX_PLAY];    // Letters taken, in square order (filled by Board::remove)
 };
 
-// Load dictionary with all word lengths
-void LoadDictionary(const char* fname) {
-    std::cout << "Loading WordFeud dictionary..." << std::endl;
-    int num_words = 0;
-    std::ifstream fin(fname);
-    std::string line;
-    
-    while (std::getline(fin, line)) {
-        // Remove carriage return if present
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-        
-        // Handle UTF-8 Swedish characters and convert to uppercase
-        std::string processed_line;
-        for (size_t i = 0; i < line.size(); ++i) {
-            unsigned char c = line[i];
-            if (c >= 'a' && c <= 'z') {
-                processed_line += (c - 'a' + 'A');
-            } else if (c == 0xC3 && i + 1 < line.size()) {
-                unsigned char next = line[i + 1];
-                if (next == 0x85) { // Å
-                    processed_line += 'Q';
-                    ++i; // Skip next byte
-                } else if (next == 0x84) { // Ä
-                    processed_line += 'W';
-                    ++i; // Skip next byte
-                } else if (next == 0x96) { // Ö
-                    processed_line += '[';
-                    ++i; // Skip next byte
-                } else {
-                    processed_line += c;
+// Board of fixed size, so a search step never allocates. The letters are kept in
+// row-major and column-major order, which makes every word one contiguous run, and
+// the occupancy as a 15-bit mask per row and per column. Moves are applied and
+// undone in place, keeping the Zobrist hash up to date.
+struct Board {
+    char rows[GRID_SIZE][GRID_SIZE];    // rows[r][c], ' ' when empty
+    char cols[GRID_SIZE][GRID_SIZE];    // cols[c][r]
+    uint16_t row_bits[GRID_SIZE];       // Bit c of row r set when (r, c) holds a tile
+    uint16_t col_bits[GRID_SIZE];       // Bit r of column c set when (r, c) holds a tile
+    uint64_t hash = 0;
+    int tiles = 0;
+
+    Board() {
+        std::fill(&rows[0][0], &rows[0][0] + GRID_SIZE * GRID_SIZE, ' ');
+        std::fill(&cols[0][0], &cols[0][0] + GRID_SIZE * GRID_SIZE, ' ');
+        std::fill(row_bits, row_bits + GRID_SIZE, 0);
+        std::fill(col_bits, col_bits + GRID_SIZE, 0);
+    }
+    explicit Board(const std::vector<std::string>& grid) : Board() {
+        for (int row = 0; row < GRID_SIZE; ++row) {
+            for (int col = 0; col < GRID_SIZE; ++col) {
+                if (grid[row][col] != ' ' && grid[row][col] != 0) {
+                    place(row, col, grid[row][col]);
                 }
-            } else if (c >= 'A' && c <= 'Z') {
-                processed_line += c;
             }
         }
-        
-        line = processed_line;
-        if (line.size() >= 1 && line.size() <= 15) { // 1-15 letter words for WordFeud (including long words)
-            g_word_trie.add(line);
-            num_words++;
+    }
+
+    inline char at(int row, int col) const { return rows[row][col]; }
+
+    inline void place(int row, int col, char c) {
+        rows[row][col] = c;
+        cols[col][row] = c;
+        row_bits[row] |= 1 << col;
+        col_bits[col] |= 1 << row;
+        hash ^= ZobristKey(row, col, c);
+        tiles++;
+    }
+
+    inline char take(int row, int col) {
+        char c = rows[row][col];
+        rows[row][col] = ' ';
+        cols[col][row] = ' ';
+        row_bits[row] &= ~(1 << col);
+        col_bits[col] &= ~(1 << row);
+        hash ^= ZobristKey(row, col, c);
+        tiles--;
+        return c;
+    }
+
+    // Take the tiles of a move, remembering their letters in it
+    void remove(Move& move) {
+        int k = 0;
+        for (uint16_t bits = move.cells; bits; bits &= bits - 1) {
+            int i = __builtin_ctz(bits);
+            move.letters[k++] = move.vertical ? take(i, move.line) : take(move.line, i);
         }
     }
-    std::cout << "Loaded " << num_words << " words." << std::endl;
-}
+
+    // Put back the tiles of a move taken by remove()
+    void restore(const Move& move) {
+        int k = 0;
+        for (uint16_t bits = move.cells; bits; bits &= bits - 1) {
+            int i = __builtin_ctz(bits);
+            if (move.vertical) {
+                place(i, move.line, move.letters[k++]);
+            } else {
+                place(move.line, i, move.letters[k++]);
+            }
+        }
+    }
+};
 
 // Parse input grid from file
 bool ParseInput(const char* filename) {
@@ -136,22 +215,27 @@ bool ParseInput(const char* filename) {
                 processed_line += (c - 'a' + 'A');
             } else if (c == 0xC3 && i + 1 < line.size()) {
                 unsigned char next = line[i + 1];
-                if (next == 0x85) { // Å
+                if (next == 0x85 || next == 0xA5) { // Å å
                     processed_line += 'Q';
                     ++i;
-                } else if (next == 0x84) { // Ä
+                } else if (next == 0x84 || next == 0xA4) { // Ä ä
                     processed_line += 'W';
                     ++i;
-                } else if (next == 0x96) { // Ö
+                } else if (next == 0x96 || next == 0xB6) { // Ö ö
                     processed_line += '[';
                     ++i;
                 } else {
-                    processed_line += c;
+                    // Any other letter is outside the WordFeud alphabet and the trie
+                    std::cerr << "Error: Unsupported letter in row " << row + 1 << " of " << filename << std::endl;
+                    return false;
                 }
             } else if (c >= 'A' && c <= 'Z') {
                 processed_line += c;
             } else if (c == ' ' || c == '_' || c == '.') {
                 processed_line += ' ';
+            } else if (c >= 0x80) {
+                std::cerr << "Error: Unsupported letter in row " << row + 1 << " of " << filename << std::endl;
+                return false;
             }
         }
         
@@ -177,272 +261,352 @@ bool ParseInput(const char* filename) {
     return true;
 }
 
-// Extract all words from current grid state
-std::vector<std::string> ExtractWords(const std::vector<std::string>& grid) {
-    std::vector<std::string> words;
-    
-    // Extract horizontal words
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        std::string current_word;
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            char c = grid[row][col];
-            if (c != ' ' && c != 0) {
-                current_word += c;
-            } else {
-                if (current_word.length() >= 2) {
-                    words.push_back(current_word);
-                }
-                current_word.clear();
-            }
-        }
-        if (current_word.length() >= 2) {
-            words.push_back(current_word);
+// Call f(start, length) for each run of set bits in a line mask
+template<typename F>
+inline bool ForEachRun(uint16_t bits, F f) {
+    while (bits) {
+        int start = __builtin_ctz(bits);
+        int length = __builtin_ctz(~(unsigned)(bits >> start));
+        if (f(start, length)) {
+            return true;
         }
+        bits &= ~(((1u << length) - 1) << start);
     }
+    return false;
+}
+
+// Extract all words from current grid state
+std::vector<std::string> ExtractWords(const Board& board) {
+    std::vector<std::string> words;
     
-    // Extract vertical words
-    for (int col = 0; col < GRID_SIZE; ++col) {
-        std::string current_word;
-        for (int row = 0; row < GRID_SIZE; ++row) {
-            char c = grid[row][col];
-            if (c != ' ' && c != 0) {
-                current_word += c;
-            } else {
-                if (current_word.length() >= 2) {
-                    words.push_back(current_word);
+    // Horizontal words, then vertical words
+    for (int vertical = 0; vertical < 2; ++vertical) {
+        for (int line = 0; line < GRID_SIZE; ++line) {
+            const char* letters = vertical ? board.cols[line] : board.rows[line];
+            ForEachRun(vertical ? board.col_bits[line] : board.row_bits[line], [&](int start, int length) {
+                if (length >= 2) {
+                    words.push_back(std::string(letters + start, length));
                 }
-                current_word.clear();
-            }
-        }
-        if (current_word.length() >= 2) {
-            words.push_back(current_word);
+                return false;
+            });
         }
     }
     
     return words;
 }
 
-// Check if all letters form a single connected component using BFS
-bool AreAllLettersConnected(const std::vector<std::string>& grid) {
-    // First, find all letter positions
-    std::vector<std::pair<int, int>> letter_positions;
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            if (grid[row][col] != ' ' && grid[row][col] != 0) {
-                letter_positions.push_back({row, col});
-            }
-        }
-    }
-    
+// Check if all letters form a single connected component by flooding the row masks
+bool AreAllLettersConnected(const Board& board) {
     // If no letters or only one letter, it's connected
-    if (letter_positions.size() <= 1) {
+    if (board.tiles <= 1) {
         return true;
     }
     
-    // Use BFS to check if all letters are reachable from the first letter
-    std::set<std::pair<int, int>> visited;
-    std::queue<std::pair<int, int>> queue;
-    
-    // Start BFS from the first letter
-    queue.push(letter_positions[0]);
-    visited.insert(letter_positions[0]);
-    
-    // Directions for horizontal/vertical movement
-    int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-    
-    while (!queue.empty()) {
-        auto current = queue.front();
-        queue.pop();
-        
-        // Check all four directions
-        for (int d = 0; d < 4; ++d) {
-            int new_row = current.first + directions[d][0];
-            int new_col = current.second + directions[d][1];
-            
-            // Check bounds
-            if (new_row >= 0 && new_row < GRID_SIZE && new_col >= 0 && new_col < GRID_SIZE) {
-                // Check if there's a letter at this position and we haven't visited it
-                if (grid[new_row][new_col] != ' ' && grid[new_row][new_col] != 0) {
-                    std::pair<int, int> neighbor = {new_row, new_col};
-                    if (visited.find(neighbor) == visited.end()) {
-                        visited.insert(neighbor);
-                        queue.push(neighbor);
-                    }
+    // Start from the first letter
+    uint16_t reached[GRID_SIZE] = {};
+    int first = 0;
+    while (board.row_bits[first] == 0) {
+        ++first;
+    }
+    reached[first] = board.row_bits[first] & -board.row_bits[first];
+    
+    // Sweep down and up, spreading along rows and into the rows next to them, until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int i = 0; i < GRID_SIZE; ++i) {
+                int row = pass ? GRID_SIZE - 1 - i : i;
+                uint16_t occupied = board.row_bits[row];
+                uint16_t spread = reached[row];
+                if (row > 0) spread |= reached[row - 1];
+                if (row < GRID_SIZE - 1) spread |= reached[row + 1];
+                spread &= occupied;
+                for (uint16_t prev = 0; prev != spread; ) {
+                    prev = spread;
+                    spread |= ((spread << 1) | (spread >> 1)) & occupied;
+                }
+                if (spread != reached[row]) {
+                    reached[row] = spread;
+                    changed = true;
                 }
             }
         }
     }
     
-    // Check if all letters were visited
-    return visited.size() == letter_positions.size();
+    // Check if all letters were reached
+    for (int row = 0; row < GRID_SIZE; ++row) {
+        if (reached[row] != board.row_bits[row]) {
+            return false;
+        }
+    }
+    return true;
 }
 
 // Check if all words in the grid are valid
-bool AreAllWordsValid(const std::vector<std::string>& grid) {
+bool AreAllWordsValid(const Board& board) {
     // First check if all letters are connected
-    if (!AreAllLettersConnected(grid)) {
+    if (!AreAllLettersConnected(board)) {
         return false;
     }
     
-    std::vector<std::string> words = ExtractWords(grid);
-    
-    for (const std::string& word : words) {
-        if (!g_word_trie.has(word)) {
-            return false;
+    for (int vertical = 0; vertical < 2; ++vertical) {
+        for (int line = 0; line < GRID_SIZE; ++line) {
+            const char* letters = vertical ? board.cols[line] : board.rows[line];
+            bool invalid = ForEachRun(vertical ? board.col_bits[line] : board.row_bits[line], [&](int start, int length) {
+                return length >= 2 && !g_words.has(letters + start, length);
+            });
+            if (invalid) {
+                return false;
+            }
         }
     }
     
     return true;
 }
 
-// Check if the grid has only one word (optionally touching starting square)
-bool IsTargetState(const std::vector<std::string>& grid) {
-    std::vector<std::string> words = ExtractWords(grid);
-    
-    if (words.size() != 1) {
-        return false;
-    }
-    
-    // Check if the single word is valid length
-    std::string word = words[0];
-    if (word.length() < 2 || word.length() > 7) {
-        return false;
+// Check if the tiles marked in `targets` (a mask per row) are all connected, by
+// flooding the row masks from one of them. Only the rows next to those already
+// reached are swept, so targets that join up close by are found quickly.
+bool AreTilesConnected(const Board& board, const uint16_t* targets) {
+    uint16_t reached[GRID_SIZE] = {};
+    int first = 0;
+    while (targets[first] == 0) {
+        ++first;
+    }
+    reached[first] = targets[first] & -targets[first];
+    int top = first;
+    int bottom = first;
+    
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; ++pass) {
+            int from = std::max(top - 1, 0);
+            int to = std::min(bottom + 1, GRID_SIZE - 1);
+            for (int i = from; i <= to; ++i) {
+                int row = pass ? from + to - i : i;
+                uint16_t occupied = board.row_bits[row];
+                uint16_t spread = reached[row];
+                if (row > 0) spread |= reached[row - 1];
+                if (row < GRID_SIZE - 1) spread |= reached[row + 1];
+                spread &= occupied;
+                for (uint16_t prev = 0; prev != spread; ) {
+                    prev = spread;
+                    spread |= ((spread << 1) | (spread >> 1)) & occupied;
+                }
+                if (spread != reached[row]) {
+                    reached[row] = spread;
+                    top = std::min(top, row);
+                    bottom = std::max(bottom, row);
+                    changed = true;
+                }
+            }
+        }
+        
+        bool all = true;
+        for (int row = 0; row < GRID_SIZE && all; ++row) {
+            all = (targets[row] & ~reached[row]) == 0;
+        }
+        if (all) {
+            return true;
+        }
     }
-    
-    // If no starting square is specified, any single word is valid
-    if (g_starting_square.first == -1) {
-        return true;
+    return false;
+}
+
+// Check the board is still connected after `move` was removed from a connected
+// board (the moves of ForEachRemoval leave only words behind). It is exactly when
+// the tiles next to the removed ones are still connected to each other, since
+// every other tile reached the removed ones through one of them.
+bool IsStillConnected(const Board& board, const Move& move) {
+    const int line = move.line;
+    const uint16_t cells = move.cells;
+    const uint16_t beside = ((cells << 1) | (cells >> 1)) & ~cells;
+    const uint16_t around = (1 << line) >> 1 | (1 << line) << 1;
+    uint16_t neighbours[GRID_SIZE] = {};
+    
+    if (!move.vertical) {
+        neighbours[line] = beside & board.row_bits[line];
+        if (line > 0) neighbours[line - 1] = cells & board.row_bits[line - 1];
+        if (line < GRID_SIZE - 1) neighbours[line + 1] = cells & board.row_bits[line + 1];
+    } else {
+        for (uint16_t bits = cells; bits; bits &= bits - 1) {
+            int row = __builtin_ctz(bits);
+            neighbours[row] = around & board.row_bits[row];
+        }
+        for (uint16_t bits = beside & board.col_bits[line]; bits; bits &= bits - 1) {
+            neighbours[__builtin_ctz(bits)] |= 1 << line;
+        }
     }
     
-    // Find the word's position and check if it contains the starting square
-    int start_row = g_starting_square.first;
-    int start_col = g_starting_square.second;
-    
-    // Check horizontal words containing starting square
+    // Nothing to join up when at most one tile touched the removed ones
+    int num_neighbours = 0;
     for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col <= GRID_SIZE - word.length(); ++col) {
-            bool matches = true;
-            for (size_t i = 0; i < word.length(); ++i) {
-                if (grid[row][col + i] != word[i]) {
-                    matches = false;
-                    break;
+        num_neighbours += __builtin_popcount(neighbours[row]);
+    }
+    return num_neighbours <= 1 || AreTilesConnected(board, neighbours);
+}
+
+// Check if the grid has only one word (optionally touching starting square)
+bool IsTargetState(const Board& board) {
+    int words = 0;
+    int word_length = 0;
+    bool covers_start = false;
+    
+    for (int vertical = 0; vertical < 2 && words <= 1; ++vertical) {
+        for (int line = 0; line < GRID_SIZE && words <= 1; ++line) {
+            ForEachRun(vertical ? board.col_bits[line] : board.row_bits[line], [&](int start, int length) {
+                if (length >= 2) {
+                    words++;
+                    word_length = length;
+                    // Square of the starting square along this line, if it lies on it
+                    int start_line = vertical ? g_starting_square.second : g_starting_square.first;
+                    int start_pos = vertical ? g_starting_square.first : g_starting_square.second;
+                    covers_start = start_line == line && start_pos >= start && start_pos < start + length;
                 }
-            }
-            if (matches && row == start_row && start_col >= col && start_col < col + (int)word.length()) {
-                return true;
-            }
+                return words > 1;
+            });
         }
     }
     
-    // Check vertical words containing starting square
-    for (int col = 0; col < GRID_SIZE; ++col) {
-        for (int row = 0; row <= GRID_SIZE - (int)word.length(); ++row) {
-            bool matches = true;
-            for (size_t i = 0; i < word.length(); ++i) {
-                if (grid[row + i][col] != word[i]) {
-                    matches = false;
-                    break;
-                }
-            }
-            if (matches && col == start_col && start_row >= row && start_row < row + (int)word.length()) {
-                return true;
-            }
-        }
+    // Check if the single word is valid length
+    if (words != 1 || word_length < 2 || word_length > 7) {
+        return false;
     }
     
-    return false;
+    // If no starting square is specified, any single word is valid
+    return g_starting_square.first == -1 || covers_start;
 }
 
-// Generate all combinations of k elements from a vector
-void GenerateCombinations(const std::vector<int>& positions, size_t k, size_t start, 
-                         std::vector<int>& current, std::vector<std::vector<int>>& results) {
-    if (current.size() == k) {
-        results.push_back(current);
-        return;
-    }
-    
-    for (size_t i = start; i <= positions.size() - (k - current.size()); ++i) {
-        current.push_back(positions[i]);
-        GenerateCombinations(positions, k, i + 1, current, results);
-        current.pop_back();
+// Check one side of a tile's crossing line: the run of `length` letters left
+// behind there if the tile is taken must be a word, or a single letter
+inline bool IsWordOrLetter(const char* letters, int length) {
+    return length < 2 || g_words.has(letters, length);
+}
+
+// Squares of a line whose tile can be taken without breaking the crossing words:
+// the parts of each crossing run on both sides of it must still be words
+uint16_t RemovableSquares(const Board& board, int vertical, int line) {
+    uint16_t removable = 0;
+    uint16_t bits = vertical ? board.col_bits[line] : board.row_bits[line];
+    for (; bits; bits &= bits - 1) {
+        int pos = __builtin_ctz(bits);
+        const char* cross = vertical ? board.rows[pos] : board.cols[pos];
+        uint16_t cross_bits = vertical ? board.row_bits[pos] : board.col_bits[pos];
+        // Tiles right before and right after this one along the crossing line
+        int before = line > 0 ? __builtin_clz(~((unsigned)cross_bits << (32 - line))) : 0;
+        int after = __builtin_ctz(~(unsigned)(cross_bits >> (line + 1)));
+        if (IsWordOrLetter(cross + line - before, before) && IsWordOrLetter(cross + line + 1, after)) {
+            removable |= 1 << pos;
+        }
     }
+    return removable;
 }
 
-// Get all possible removal combinations (1-7 letters from same row/column)
-std::vector<std::vector<std::pair<int, int>>> GetRemovalCombinations(const std::vector<std::string>& grid) {
-    std::vector<std::vector<std::pair<int, int>>> combinations;
-    
-    // Generate removal combinations for each row
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        std::vector<int> positions;
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            if (grid[row][col] != ' ' && (g_starting_square.first == -1 || std::make_pair(row, col) != g_starting_square)) {
-                positions.push_back(col);
-            }
+// Reverse plays along one run of tiles, ending at run_end. The tile at `pos` is
+// taken; from there the play either ends, if the letters after it to the end of
+// the run form a word, or goes on. Letters kept between two taken tiles are walked
+// down the trie as they are added, so a stretch of two or more letters no word
+// starts with ends the branch. A single kept letter is always legal, so the first
+// one is kept even when no word starts with it.
+struct RunRemovals {
+    const char* letters;
+    uint16_t removable;
+    int run_end;
+    int min_tiles;      // Plays with fewer taken tiles are listed along the other axis
+    Move& move;
+
+    template<typename F>
+    bool take(int pos, int taken, F& f) {
+        move.cells |= 1 << pos;
+        taken++;
+        if (taken >= min_tiles && IsWordOrLetter(letters + pos + 1, run_end - pos) && f(move)) {
+            return true;
         }
-        
-        // Generate all possible combinations of length 1-7
-        for (size_t len = 1; len <= std::min(size_t(7), positions.size()); ++len) {
-            std::vector<std::vector<int>> combos;
-            std::vector<int> current;
-            GenerateCombinations(positions, len, 0, current, combos);
-            
-            for (const auto& combo : combos) {
-                std::vector<std::pair<int, int>> removal;
-                for (int pos : combo) {
-                    removal.push_back({row, pos});
-                }
-                combinations.push_back(removal);
-            }
+        if (taken < MAX_PLAY && extend(pos + 1, taken, g_words.trie().root(), 0, f)) {
+            return true;
         }
+        move.cells &= ~(1 << pos);
+        return false;
     }
-    
-    // Generate removal combinations for each column
-    for (int col = 0; col < GRID_SIZE; ++col) {
-        std::vector<int> positions;
-        for (int row = 0; row < GRID_SIZE; ++row) {
-            if (grid[row][col] != ' ' && (g_starting_square.first == -1 || std::make_pair(row, col) != g_starting_square)) {
-                positions.push_back(row);
-            }
+
+    template<typename F>
+    bool extend(int pos, int taken, Trie::NodeIx kept, int kept_length, F& f) {
+        if (pos > run_end) {
+            return false;
         }
-        
-        // Generate all possible combinations of length 1-7
-        for (size_t len = 1; len <= std::min(size_t(7), positions.size()); ++len) {
-            std::vector<std::vector<int>> combos;
-            std::vector<int> current;
-            GenerateCombinations(positions, len, 0, current, combos);
+        // Take the tile here, closing the letters kept since the last taken one
+        if (((removable >> pos) & 1) && (kept_length < 2 || g_words.trie().isWordEnd(kept)) &&
+            take(pos, taken, f)) {
+            return true;
+        }
+        // Or keep it, if some word starts with the kept letters
+        Trie::NodeIx next = g_words.trie().decend(kept, letters[pos] - 'A');
+        if (next != Trie::NONE) {
+            return extend(pos + 1, taken, next, kept_length + 1, f);
+        }
+        // A lone kept letter needs no word; it can only be closed by the next tile
+        if (kept_length == 0 && pos + 1 <= run_end && ((removable >> (pos + 1)) & 1)) {
+            return take(pos + 1, taken, f);
+        }
+        return false;
+    }
+};
+
+// Call f(move) for every legal reverse play until f returns true: 1-7 tiles taken
+// from one row or column with no empty square between them (a play fills one gap-
+// free stretch of a line), leaving only words in that line and the crossing ones.
+// Moves are built square by square and nothing is stored, so memory stays
+// constant. Single tiles are listed once, along their row. The starting square
+// is never removed.
+template<typename F>
+bool ForEachRemoval(const Board& board, F f) {
+    Move move;
+    for (int vertical = 0; vertical < 2; ++vertical) {
+        for (int line = 0; line < GRID_SIZE; ++line) {
+            uint16_t removable = RemovableSquares(board, vertical, line);
+            if (g_starting_square.first != -1) {
+                int start_line = vertical ? g_starting_square.second : g_starting_square.first;
+                int start_pos = vertical ? g_starting_square.first : g_starting_square.second;
+                if (start_line == line) {
+                    removable &= ~(1 << start_pos);
+                }
+            }
+            if (removable == 0) {
+                continue;
+            }
             
-            for (const auto& combo : combos) {
-                std::vector<std::pair<int, int>> removal;
-                for (int pos : combo) {
-                    removal.push_back({pos, col});
+            move.line = line;
+            move.vertical = vertical;
+            move.cells = 0;
+            const char* letters = vertical ? board.cols[line] : board.rows[line];
+            bool stop = ForEachRun(vertical ? board.col_bits[line] : board.row_bits[line], [&](int start, int length) {
+                RunRemovals run{letters, removable, start + length - 1, vertical ? 2 : 1, move};
+                for (int first = start; first < start + length; ++first) {
+                    // The letters before the first taken tile must stay a word
+                    if (((removable >> first) & 1) && IsWordOrLetter(letters + start, first - start) &&
+                        run.take(first, 0, f)) {
+                        return true;
+                    }
                 }
-                combinations.push_back(removal);
+                return false;
+            });
+            if (stop) {
+                return true;
             }
         }
     }
-    
-    return combinations;
-}
-
-// Apply removal and return new grid state
-std::vector<std::string> ApplyRemoval(const std::vector<std::string>& grid, const std::vector<std::pair<int, int>>& removal) {
-    std::vector<std::string> new_grid = grid;
-    
-    for (const auto& pos : removal) {
-        new_grid[pos.first][pos.second] = ' ';
-    }
-    
-    return new_grid;
+    return false;
 }
 
 // Convert removal to human-readable move description
-std::string DescribeMove(const std::vector<std::pair<int, int>>& removal, const std::vector<std::string>& original_grid) {
-    if (removal.empty()) return "";
+std::string DescribeMove(const Move& move) {
+    if (move.cells == 0) return "";
     
     std::string letters;
-    for (const auto& pos : removal) {
-        char c = original_grid[pos.first][pos.second];
+    for (int i = 0; i < __builtin_popcount(move.cells); ++i) {
+        char c = move.letters[i];
         // Convert back to readable format
         if (c == 'Q') letters += "\u00c5";
         else if (c == 'W') letters += "\u00c4";
@@ -450,14 +614,14 @@ std::string DescribeMove(const std::vector<std::pair<int, int>>& removal, const
         else letters += c;
     }
     
-    // Determine if horizontal or vertical removal
-    bool horizontal = true;
-    if (removal.size() > 1) {
-        horizontal = (removal[0].first == removal[1].first);
-    }
+    // Single tiles are described as taken from their row
+    int first = __builtin_ctz(move.cells);
+    int row = move.vertical ? first : move.line;
+    int col = move.vertical ? move.line : first;
+    bool horizontal = !move.vertical || __builtin_popcount(move.cells) == 1;
     
-    char coord_letter = 'A' + removal[0].second;
-    int coord_number = removal[0].first + 1;
+    char coord_letter = 'A' + col;
+    int coord_number = row + 1;
     
     if (horizontal) {
         return "Remove \"" + letters + "\" from row " + std::to_string(coord_number) + 
@@ -468,16 +632,16 @@ std::string DescribeMove(const std::vector<std::pair<int, int>>& removal, const
     }
 }
 
-// Print grid state
-void PrintGrid(const std::vector<std::string>& grid) {
-    output("   A B C D E F G H I J K L M N O\n");
+// The board as text, one line per row followed by a blank line
+std::string FormatGrid(const Board& board) {
+    std::string text = "   A B C D E F G H I J K L M N O\n";
     for (int i = 0; i < GRID_SIZE; ++i) {
         std::string line = "";
         if (i + 1 < 10) line += " ";
         line += std::to_string(i + 1) + " ";
         
         for (int j = 0; j < GRID_SIZE; ++j) {
-            char c = grid[i][j];
+            char c = board.at(i, j);
             if (c == ' ') {
                 line += ". ";
             } else if (g_starting_square.first != -1 && i == g_starting_square.first && j == g_starting_square.second) {
@@ -494,76 +658,270 @@ void PrintGrid(const std::vector<std::string>& grid) {
                 else line += std::string(1, c) + " ";
             }
         }
-        output(line + "\n");
+        text += line + "\n";
     }
-    output("\n");
+    return text + "\n";
 }
 
-// Recursive backtracking search for reverse play sequence
-bool FindReverseSequence(GameState current_state, std::vector<GameState>& solution_path, int max_depth = 100) {
-    // Check if we've reached a new deepest position
-    if (current_state.moves_count > g_deepest_reached) {
-        g_deepest_reached = current_state.moves_count;
-        output("New deepest position reached: depth " + std::to_string(current_state.moves_count) + "\n");
-        PrintGrid(current_state.grid);
-        
-        // Also show remaining words
-        std::vector<std::string> remaining_words = ExtractWords(current_state.grid);
-        output("Remaining words (" + std::to_string(remaining_words.size()) + "): ");
-        for (const auto& word : remaining_words) {
-            output("\"" + word + "\" ");
+// Print a board with a single output() call, so its lines are not interleaved
+// with other threads' output
+void PrintGrid(const Board& board) {
+    output(FormatGrid(board));
+}
+
+// Dead-end entry fields
+inline uint32_t DeadEndCheck(uint64_t entry) { return (uint32_t)(entry >> 32); }
+inline int DeadEndBudget(uint64_t entry) { return (int)(entry >> 16 & 0xFFFF); }
+inline int DeadEndReach(uint64_t entry) { return (int)(entry & 0xFFFF); }
+
+// First entry of a board's bucket
+inline std::atomic<uint64_t>* DeadEndBucket(uint64_t hash) {
+    return &g_dead_ends[hash & ((1 << DEAD_END_BITS) - DEAD_END_WAYS)];
+}
+
+// True if the board was already searched without success with at least `budget` moves left
+bool FindDeadEnd(uint64_t hash, int budget, int& reach) {
+    std::atomic<uint64_t>* bucket = DeadEndBucket(hash);
+    for (int way = 0; way < DEAD_END_WAYS; ++way) {
+        uint64_t entry = bucket[way].load(std::memory_order_relaxed);
+        if (entry != 0 && DeadEndCheck(entry) == (uint32_t)(hash >> 32) && DeadEndBudget(entry) >= budget) {
+            reach = DeadEndReach(entry);
+            return true;
         }
-        output("\n\n");
     }
+    return false;
+}
+
+// Record a dead end, in the board's own entry if it has one, else in place of the
+// entry with the least moves below it (the cheapest to search again)
+void AddDeadEnd(uint64_t hash, int budget, int reach) {
+    const uint64_t entry = (hash >> 32 << 32) | (uint64_t)budget << 16 | (uint64_t)reach;
+    std::atomic<uint64_t>* bucket = DeadEndBucket(hash);
+    int victim = 0;
+    int victim_reach = MAX_DEPTH + 1;
+    for (int way = 0; way < DEAD_END_WAYS; ++way) {
+        uint64_t old = bucket[way].load(std::memory_order_relaxed);
+        if (old != 0 && DeadEndCheck(old) == (uint32_t)(hash >> 32)) {
+            if (budget >= DeadEndBudget(old)) {
+                bucket[way].store(entry, std::memory_order_relaxed);
+            }
+            return;
+        }
+        int old_reach = old == 0 ? -1 : DeadEndReach(old);
+        if (old_reach < victim_reach) {
+            victim = way;
+            victim_reach = old_reach;
+        }
+    }
+    bucket[victim].store(entry, std::memory_order_relaxed);
+}
+
+// Entries in use
+size_t CountDeadEnds() {
+    size_t count = 0;
+    for (const std::atomic<uint64_t>& entry : g_dead_ends) {
+        count += entry.load(std::memory_order_relaxed) != 0;
+    }
+    return count;
+}
+
+// Print a board if it is deeper than any reached so far
+void ReportDepth(const Board& board, int depth) {
+    if (depth <= g_deepest_reached.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_deepest_mutex);
+    if (depth <= g_deepest_reached.load(std::memory_order_relaxed)) {
+        return;
+    }
+    g_deepest_reached.store(depth, std::memory_order_relaxed);
+    std::string report = "New deepest position reached: depth " + std::to_string(depth) + "\n";
+    report += FormatGrid(board);
+    
+    // Also show remaining words
+    std::vector<std::string> remaining_words = ExtractWords(board);
+    report += "Remaining words (" + std::to_string(remaining_words.size()) + "): ";
+    for (const auto& word : remaining_words) {
+        report += "\"" + word + "\" ";
+    }
+    output(report + "\n\n");
+}
+
+// Count a tried move, adding to the shared total in batches for progress reports
+inline void CountCombination(uint64_t& combinations) {
+    const uint64_t BATCH = 1 << 16;
+    if ((++combinations & (BATCH - 1)) != 0) {
+        return;
+    }
+    uint64_t total = g_combinations_tried.fetch_add(BATCH, std::memory_order_relaxed) + BATCH;
     
-    // Check if we've reached the target state
-    if (IsTargetState(current_state.grid)) {
-        solution_path.push_back(current_state);
-        output("Found target state at depth " + std::to_string(current_state.moves_count) + "!\n");
+    // Print progress every 10,000,000 combinations
+    if (total % 10000000 < BATCH) {
+        auto current_time = std::chrono::high_resolution_clock::now();
+        auto elapsed_seconds = std::chrono::duration<double>(current_time - g_start_time).count();
+        double combinations_per_second = total / elapsed_seconds;
+        output("Combinations tried: " + std::to_string(total) + 
+               " (" + std::to_string((int)combinations_per_second) + " comb/sec, " +
+               std::to_string(CountDeadEnds()) + " dead ends)\n");
+    }
+}
+
+// Removals from the input board to the target, once found
+std::vector<Move> g_solution;
+
+// Search state of one thread, on its own cache lines
+struct alignas(64) Worker {
+    Board board;               // Changed in place by the search
+    Move path[MAX_DEPTH];      // Removals from the input board to `board`
+    uint64_t combinations = 0;
+    uint64_t dead_end_hits = 0;
+};
+
+// Recursive backtracking search for reverse play sequence. The board is changed
+// in place and restored before returning. Boards that cannot be reduced are
+// remembered by hash, so a board reached again through another order of removals,
+// by this thread or another, is skipped instead of searched again. `reach` returns
+// the most moves the search made below the board. Returns false straight away
+// once another thread has found a target.
+bool FindReverseSequence(Worker& worker, int depth, int& reach) {
+    Board& board = worker.board;
+    reach = 0;
+    if (g_solved.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    
+    // Check if we've reached a new deepest position
+    ReportDepth(board, depth);
+    
+    // Check if we've reached the target state; the first thread to get one keeps it
+    if (IsTargetState(board)) {
+        bool expected = false;
+        if (g_solved.compare_exchange_strong(expected, true)) {
+            g_solution.assign(worker.path, worker.path + depth);
+            output("Found target state at depth " + std::to_string(depth) + "!\n");
+        }
         return true;
     }
     
     // Depth limit to prevent infinite recursion
-    if (current_state.moves_count >= max_depth) {
+    int budget = MAX_DEPTH - depth;
+    if (budget <= 0) {
         return false;
     }
     
-    // Get all possible removals
-    std::vector<std::vector<std::pair<int, int>>> removals = GetRemovalCombinations(current_state.grid);
+    // Skip boards already searched without success with at least this many moves left
+    if (FindDeadEnd(board.hash, budget, reach)) {
+        worker.dead_end_hits++;
+        if (depth + reach > g_deepest_reached.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(g_deepest_mutex);
+            if (depth + reach > g_deepest_reached.load(std::memory_order_relaxed)) {
+                g_deepest_reached.store(depth + reach, std::memory_order_relaxed);
+                output("New deepest position reached: depth " + std::to_string(depth + reach) +
+                       " (below an already searched board)\n");
+            }
+        }
+        return false;
+    }
     
     // Try each removal
-    for (const auto& removal : removals) {
-        g_combinations_tried++;
+    bool found = false;
+    ForEachRemoval(board, [&](Move& move) {
+        CountCombination(worker.combinations);
+        board.remove(move);
         
-        // Print progress every 10,000 combinations
-        if (g_combinations_tried % 10000000 == 0) {
-            auto current_time = std::chrono::high_resolution_clock::now();
-            auto elapsed_seconds = std::chrono::duration<double>(current_time - g_start_time).count();
-            double combinations_per_second = g_combinations_tried / elapsed_seconds;
-            output("Combinations tried: " + std::to_string(g_combinations_tried) + 
-                   " (" + std::to_string((int)combinations_per_second) + " comb/sec)\n");
+        // Recurse if the resulting grid is still in one piece
+        if (IsStillConnected(board, move)) {
+            worker.path[depth] = move;
+            int child_reach;
+            found = FindReverseSequence(worker, depth + 1, child_reach);
+            reach = std::max(reach, child_reach + 1);
         }
         
-        std::vector<std::string> new_grid = ApplyRemoval(current_state.grid, removal);
-        
-        // Check if the resulting grid has all valid words
-        bool valid = AreAllWordsValid(new_grid);
-        
-        if (valid) {
-            GameState new_state(new_grid);
-            new_state.moves_count = current_state.moves_count + 1;
-            new_state.play_sequence = current_state.play_sequence;
-            new_state.play_sequence.push_back(DescribeMove(removal, current_state.grid));
-            
-            // Recurse
-            if (FindReverseSequence(new_state, solution_path, max_depth)) {
-                solution_path.insert(solution_path.begin(), current_state);
-                return true;
-            }
+        board.restore(move);
+        return found || g_solved.load(std::memory_order_relaxed);
+    });
+    
+    // A search cut short because another thread finished proves nothing
+    if (!found && !g_solved.load(std::memory_order_relaxed)) {
+        AddDeadEnd(board.hash, budget, reach);
+    }
+    return found;
+}
+
+// A board SPLIT_DEPTH plays below the input (or fewer, if it is a target), given
+// by the removals leading to it
+struct Task {
+    Move moves[SPLIT_DEPTH];
+    int depth;
+};
+
+// Collect the distinct boards SPLIT_DEPTH plays below the input, in search order
+void SplitSearch(Worker& worker, int depth, std::unordered_set<uint64_t>& seen, std::vector<Task>& tasks) {
+    Board& board = worker.board;
+    ReportDepth(board, depth);
+    if (depth == SPLIT_DEPTH || IsTargetState(board)) {
+        Task task;
+        std::copy(worker.path, worker.path + depth, task.moves);
+        task.depth = depth;
+        tasks.push_back(task);
+        return;
+    }
+    
+    ForEachRemoval(board, [&](Move& move) {
+        CountCombination(worker.combinations);
+        board.remove(move);
+        if (IsStillConnected(board, move) && seen.insert(board.hash).second) {
+            worker.path[depth] = move;
+            SplitSearch(worker, depth + 1, seen, tasks);
         }
+        board.restore(move);
+        return false;
+    });
+}
+
+// Search the tasks on all cores, each thread taking the next unclaimed one, until
+// they are done or a thread finds a target
+bool FindReverseSequenceParallel(const Board& initial_board, uint64_t& combinations, uint64_t& dead_end_hits) {
+    std::unique_ptr<Worker> splitter(new Worker());
+    splitter->board = initial_board;
+    std::unordered_set<uint64_t> seen = {initial_board.hash};
+    std::vector<Task> tasks;
+    SplitSearch(*splitter, 0, seen, tasks);
+    
+    unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+    output("Searching " + std::to_string(tasks.size()) + " boards " + std::to_string(SPLIT_DEPTH) +
+           " plays deep on " + std::to_string(num_threads) + " threads\n");
+    
+    std::vector<Worker> workers(num_threads);
+    std::atomic<size_t> next_task(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            Worker& worker = workers[t];
+            size_t i;
+            while (!g_solved.load(std::memory_order_relaxed) && (i = next_task++) < tasks.size()) {
+                const Task& task = tasks[i];
+                worker.board = initial_board;
+                for (int d = 0; d < task.depth; ++d) {
+                    worker.path[d] = task.moves[d];
+                    worker.board.remove(worker.path[d]);
+                }
+                int reach;
+                FindReverseSequence(worker, task.depth, reach);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
     }
     
-    return false;
+    combinations = splitter->combinations;
+    dead_end_hits = 0;
+    for (const Worker& worker : workers) {
+        combinations += worker.combinations;
+        dead_end_hits += worker.dead_end_hits;
+    }
+    return g_solved.load();
 }
 
 int main(int argc, char* argv[]) {
@@ -572,9 +930,14 @@ int main(int argc, char* argv[]) {
     
     // Initialize timing
     g_start_time = std::chrono::high_resolution_clock::now();
+    InitZobrist();
     
-    // Load dictionary
-    LoadDictionary(DICTIONARY);
+    // Load dictionary (served from the cache built by any of the programs)
+    if (!g_dictionary.open(DICTIONARY)) {
+        return 1;
+    }
+    g_words = g_dictionary.view(1, GRID_SIZE);
+    std::cout << "Loaded " << g_dictionary.numWords(0) << " words." << std::endl;
     
     // Parse input
     if (!ParseInput(INPUT_GRID_FILE)) {
@@ -584,20 +947,21 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    Board initial_board(g_grid);
     output("Initial grid:\n");
-    PrintGrid(g_grid);
+    PrintGrid(initial_board);
     
     // Validate initial grid
-    std::vector<std::string> extracted_words = ExtractWords(g_grid);
+    std::vector<std::string> extracted_words = ExtractWords(initial_board);
     output("Extracted words from grid:\n");
     for (const std::string& word : extracted_words) {
-        output("  \"" + word + "\" (len=" + std::to_string(word.length()) + ") - " + (g_word_trie.has(word) ? "VALID" : "INVALID"));
+        output("  \"" + word + "\" (len=" + std::to_string(word.length()) + ") - " + (g_words.has(word) ? "VALID" : "INVALID"));
         output(" [");
         for (char c : word) output(std::to_string((int)(unsigned char)c) + " ");
         output("]\n");
     }
     
-    if (!AreAllWordsValid(g_grid)) {
+    if (!AreAllWordsValid(initial_board)) {
         std::cerr << "Error: Initial grid contains invalid words!" << std::endl;
         return 1;
     }
@@ -605,27 +969,35 @@ int main(int argc, char* argv[]) {
     output("Searching for reverse play sequence...\n");
     
     // Find reverse sequence
-    GameState initial_state(g_grid);
-    std::vector<GameState> solution_path;
+    uint64_t combinations;
+    uint64_t dead_end_hits;
     
-    if (FindReverseSequence(initial_state, solution_path)) {
+    if (FindReverseSequenceParallel(initial_board, combinations, dead_end_hits)) {
         output("\n=== WORDFEUD PLAYING PLAN ===\n");
-        output("Found solution in " + std::to_string(solution_path.size() - 1) + " moves!\n");
+        output("Found solution in " + std::to_string(g_solution.size()) + " moves!\n");
+        
+        // Replay the removals to get the board after each of them
+        std::vector<Board> path(1, initial_board);
+        for (Move move : g_solution) {
+            path.push_back(path.back());
+            path.back().remove(move);
+        }
         
-        // Print the solution in reverse order (from simple to complex)
-        for (int i = solution_path.size() - 1; i >= 0; --i) {
-            output("\n--- Step " + std::to_string(solution_path.size() - i) + " ---\n");
-            if (i > 0) {
-                output("Play: " + solution_path[i - 1].play_sequence.back() + "\n");
+        // Print the solution in reverse order (from simple to complex); the play
+        // onto board i puts back removal i
+        for (int i = path.size() - 1; i >= 0; --i) {
+            output("\n--- Step " + std::to_string(path.size() - i) + " ---\n");
+            if (i < (int)path.size() - 1) {
+                output("Play: " + DescribeMove(g_solution[i]) + "\n");
             } else {
                 output("Start with this configuration:\n");
             }
-            PrintGrid(solution_path[i].grid);
+            PrintGrid(path[i]);
         }
         
         output("=== PLAYING SEQUENCE (FORWARD) ===\n");
-        for (size_t i = 0; i < solution_path[0].play_sequence.size(); ++i) {
-            output("Move " + std::to_string(i + 1) + ": " + solution_path[0].play_sequence[i] + "\n");
+        for (size_t i = 0; i < g_solution.size(); ++i) {
+            output("Move " + std::to_string(i + 1) + ": " + DescribeMove(g_solution[g_solution.size() - 1 - i]) + "\n");
         }
         
     } else {
@@ -636,9 +1008,11 @@ int main(int argc, char* argv[]) {
     // Print final statistics
     auto end_time = std::chrono::high_resolution_clock::now();
     auto total_seconds = std::chrono::duration<double>(end_time - g_start_time).count();
-    double avg_combinations_per_second = g_combinations_tried / total_seconds;
-    output("Done. Total combinations tried: " + std::to_string(g_combinations_tried) +
+    double avg_combinations_per_second = combinations / total_seconds;
+    output("Done. Total combinations tried: " + std::to_string(combinations) +
            " (avg " + std::to_string((int)avg_combinations_per_second) + " comb/sec)\n");
+    output("Transposition table: " + std::to_string(CountDeadEnds()) + " of " + std::to_string(1 << DEAD_END_BITS) + " entries used, " +
+           std::to_string(dead_end_hits) + " hits\n");
     
     // Close output file
     if (output_file.is_open()) {